@@ -0,0 +1,490 @@
+// Benchmark.cpp : Runs a fixed corpus of canonical machines through AbstractMachine::LoadAndRun and reports their throughput.
+// Every run is checked against a reference simulation first, so a faster machine that computes the wrong tape does not count.
+//
+// Usage: benchmark [--baseline FILE] [--write-baseline] [--gate] [--tolerance FRACTION] [--reps N] [--only NAME] [--profile] [--folded FILE] [--precompiled] [--cache DIR] [--accelerate]
+// With a baseline file, any program whose ns/step is worse than the baseline by more than the tolerance is marked as a regression.
+// The exit code is 1 for a regression only with --gate. ns/step depends on the machine, so a gate needs a baseline written on the same machine.
+// --profile prints the concept profile of every language after each program; it needs a build with LANGUAGE_PROFILE=1.
+// --folded runs every program once more, untimed, sampling each instruction, and writes its state call chains to FILE as folded stacks.
+// --precompiled compiles every program to a ProgramImage first and times installing and running the image instead.
+// --cache runs every program through a ProgramCache in DIR, so the first run of a program compiles it into the cache unless an earlier process did.
+// --accelerate turns macro steps on; steps then counts the ones replayed steps stand for, and the tape is checked all the same.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <map>
+#include <filesystem>
+#include <sys/resource.h>
+
+#include "../ProgramCache.h"
+
+// A Turing machine as a transition table over `symbols` symbols, symbol 0 being the blank.
+// move is -1 (left), 0 (stay) or 1 (right). next is a state, or Reject or Accept to halt.
+struct Transition {
+	int state;
+	int read;
+	int write;
+	int move;
+	int next;
+};
+
+struct TuringMachine {
+	static constexpr int Reject = -1;
+	static constexpr int Accept = -2;
+
+	int symbols;
+	std::vector<Transition> table;
+	std::map<long long, int> input; // cell -> symbol, everything else blank
+	int start = 0;
+	long long head = 0;
+};
+
+// The result of running a TuringMachine directly, used to check the AbstractMachine got the same tape.
+struct Reference {
+	std::map<long long, int> tape;
+	long long head = 0;
+	unsigned long long steps = 0;
+	bool accepted = false;
+};
+
+Reference Simulate(const TuringMachine& tm) {
+	std::map<std::pair<int, int>, Transition> delta;
+	for (const Transition& t : tm.table) delta[{ t.state, t.read }] = t;
+
+	Reference ref;
+	ref.tape = tm.input;
+	ref.head = tm.head;
+	int q = tm.start;
+	while (q >= 0 && ref.steps < 100000000) {
+		auto found = delta.find({ q, ref.tape.contains(ref.head) ? ref.tape[ref.head] : 0 });
+		if (found == delta.end()) break;
+		const Transition& t = found->second;
+		ref.tape[ref.head] = t.write;
+		ref.head += t.move;
+		q = t.next;
+		++ref.steps;
+	}
+	ref.accepted = (q == TuringMachine::Accept);
+	return ref;
+}
+
+// Compiling a TuringMachine to machine-language states. The tape is bool, so each symbol takes k cells with its bit i in cell i,
+// and the head rests on the first cell of a symbol between transitions. State names must be words, so numbers are spelled in letters.
+int Bits(int symbols) {
+	int k = 1;
+	while ((1 << k) < symbols) ++k;
+	return k;
+}
+
+std::string Letters(int n) {
+	std::string s;
+	do {
+		s += static_cast<char>('A' + n % 26);
+		n /= 26;
+	} while (n > 0);
+	return s;
+}
+
+std::string StateName(int q) {
+	if (q == TuringMachine::Reject) return "HR";
+	if (q == TuringMachine::Accept) return "HA";
+	return "S" + Letters(q);
+}
+
+// The state reached after reading the bits so far (a for 0, b for 1) in state q.
+std::string ReadName(int q, const std::string& bits) {
+	return StateName(q) + "x" + bits;
+}
+
+Medium<char8_t> Line(const std::string& s) {
+	return Medium<char8_t>(s.begin(), s.end());
+}
+
+ProgramFile<char8_t> Compile(const TuringMachine& tm) {
+	int k = Bits(tm.symbols);
+	std::map<std::pair<int, int>, Transition> delta;
+	int states = 0;
+	for (const Transition& t : tm.table) {
+		delta[{ t.state, t.read }] = t;
+		states = std::max(states, t.state + 1);
+	}
+
+	ProgramFile<char8_t> file;
+	file.push_back(Line("name HR"));
+	file.push_back(Line("accept name HA"));
+
+	for (int q = 0; q < states; ++q) {
+		file.push_back(Line("name " + StateName(q) + " branch " + ReadName(q, "a") + " " + ReadName(q, "b")));
+
+		// decoding: one state per prefix of bits read
+		for (int length = 1; length < k; ++length) {
+			for (int prefix = 0; prefix < (1 << length); ++prefix) {
+				std::string bits;
+				for (int i = 0; i < length; ++i) bits += (prefix >> i) & 1 ? 'b' : 'a';
+				file.push_back(Line("name " + ReadName(q, bits) + " right; branch " + ReadName(q, bits + "a") + " " + ReadName(q, bits + "b")));
+			}
+		}
+
+		// one state per symbol read, carrying out the transition; the head is on the symbol's last cell
+		for (int s = 0; s < (1 << k); ++s) {
+			std::string bits;
+			for (int i = 0; i < k; ++i) bits += (s >> i) & 1 ? 'b' : 'a';
+
+			std::string body;
+			auto instruction = [&body](const std::string& i) {
+				if (!body.empty()) body += "; ";
+				body += i;
+			};
+			auto found = delta.find({ q, s });
+			if (found != delta.end()) {
+				const Transition& t = found->second;
+				for (int i = k - 1; i >= 0; --i) {
+					if (((t.write >> i) & 1) != ((s >> i) & 1)) instruction(std::string("write ") + ((t.write >> i) & 1 ? "1" : "0"));
+					if (i > 0) instruction("left");
+				}
+				if (t.move == 1) instruction(k == 1 ? "right" : "move " + std::to_string(k));
+				if (t.move == -1) instruction(k == 1 ? "left" : "move -" + std::to_string(k));
+				instruction("jump " + StateName(t.next));
+			}
+			else {
+				// no transition: halt, leaving the head on the symbol
+				for (int i = k - 1; i > 0; --i) instruction("left");
+			}
+			file.push_back(Line("name " + ReadName(q, bits) + " " + body));
+		}
+	}
+
+	// the input, then the start
+	std::string setup;
+	for (const auto& [cell, symbol] : tm.input) {
+		for (int i = 0; i < k; ++i) {
+			if ((symbol >> i) & 1) setup += "goto " + std::to_string(cell * k + i) + "; write 1; ";
+		}
+	}
+	setup += "goto " + std::to_string(tm.head * k);
+	file.push_back(Line(setup));
+	file.push_back(Line("jump " + StateName(tm.start)));
+	return file;
+}
+
+// The symbol at cell of the machine's tape, decoded from its k bool cells.
+int Decode(AbstractMachine& machine, long long cell, int k) {
+	int symbol = 0;
+	long long zero = static_cast<long long>(machine.Tape->Tape.size()) / 2;
+	for (int i = 0; i < k; ++i) {
+		long long idx = cell * k + i + zero;
+		if (idx >= 0 && idx < static_cast<long long>(machine.Tape->Tape.size()) && machine.Tape->Tape[static_cast<std::size_t>(idx)]) symbol |= 1 << i;
+	}
+	return symbol;
+}
+
+// The corpus
+
+TuringMachine BusyBeaver3() {
+	// 3-state, 2-symbol champion: 14 steps, 6 ones
+	TuringMachine tm{ 2, {
+		{0, 0, 1, 1, 1}, {0, 1, 1, 1, TuringMachine::Accept},
+		{1, 0, 0, 1, 2}, {1, 1, 1, 1, 1},
+		{2, 0, 1, -1, 2}, {2, 1, 1, -1, 0},
+	}, {} };
+	return tm;
+}
+
+TuringMachine BusyBeaver4() {
+	// 4-state, 2-symbol champion: 107 steps, 13 ones
+	TuringMachine tm{ 2, {
+		{0, 0, 1, 1, 1}, {0, 1, 1, -1, 1},
+		{1, 0, 1, -1, 0}, {1, 1, 0, -1, 2},
+		{2, 0, 1, 1, TuringMachine::Accept}, {2, 1, 1, -1, 3},
+		{3, 0, 1, 1, 3}, {3, 1, 0, 1, 0},
+	}, {} };
+	return tm;
+}
+
+// Counts from 0 until the counter overflows its n digits. Symbols: blank, 0, 1, and the # that marks the left end.
+TuringMachine BinaryIncrement(int n) {
+	enum { B, Zero, One, End };
+	enum { Inc, Ret };
+	TuringMachine tm{ 4, {
+		{Inc, One, Zero, -1, Inc}, {Inc, Zero, One, 1, Ret}, {Inc, End, End, 0, TuringMachine::Accept},
+		{Ret, Zero, Zero, 1, Ret}, {Ret, One, One, 1, Ret}, {Ret, B, B, -1, Inc},
+	}, {} };
+	tm.input[-n] = End;
+	for (long long i = -n + 1; i <= 0; ++i) tm.input[i] = Zero;
+	tm.start = Inc;
+	return tm;
+}
+
+// Adds two n-bit numbers in one pass. Each cell holds a bit pair (a, b), least significant first, and is overwritten by the sum bit.
+TuringMachine BinaryAdd(unsigned long long a, unsigned long long b, int n) {
+	enum { B, P00, P01, P10, P11, R0, R1 };
+	enum { C0, C1 };
+	TuringMachine tm{ 7, {
+		{C0, P00, R0, 1, C0}, {C0, P01, R1, 1, C0}, {C0, P10, R1, 1, C0}, {C0, P11, R0, 1, C1}, {C0, B, B, 0, TuringMachine::Accept},
+		{C1, P00, R1, 1, C0}, {C1, P01, R0, 1, C1}, {C1, P10, R0, 1, C1}, {C1, P11, R1, 1, C1}, {C1, B, R1, 0, TuringMachine::Accept},
+	}, {} };
+	for (int i = 0; i < n; ++i) {
+		tm.input[i] = P00 + static_cast<int>((a >> i) & 1) * 2 + static_cast<int>((b >> i) & 1);
+	}
+	return tm;
+}
+
+// Writes m * n ones after the input 1^m # 1^n #. Symbols: blank, 1, #, and the markers x and y.
+TuringMachine UnaryMultiply(int m, int n) {
+	enum { B, One, Sep, X, Y };
+	TuringMachine tm{ 5, {
+		{0, One, X, 1, 1}, {0, Sep, Sep, 0, TuringMachine::Accept},
+		{1, One, One, 1, 1}, {1, Sep, Sep, 1, 2},
+		{2, One, Y, 1, 3}, {2, Sep, Sep, -1, 5},
+		{3, One, One, 1, 3}, {3, Sep, Sep, 1, 3}, {3, B, One, -1, 4},
+		{4, One, One, -1, 4}, {4, Sep, Sep, -1, 4}, {4, Y, Y, 1, 2},
+		{5, Y, One, -1, 5}, {5, Sep, Sep, -1, 6},
+		{6, One, One, -1, 6}, {6, X, X, 1, 0},
+	}, {} };
+	long long cell = 0;
+	for (int i = 0; i < m; ++i) tm.input[cell++] = One;
+	tm.input[cell++] = Sep;
+	for (int i = 0; i < n; ++i) tm.input[cell++] = One;
+	tm.input[cell++] = Sep;
+	return tm;
+}
+
+// Accepts palindromes over {a, b} by erasing matching ends.
+TuringMachine Palindrome(const std::string& word) {
+	enum { B, A, Bb };
+	enum { Q0, QA, QA2, QB, QB2, Back };
+	TuringMachine tm{ 3, {
+		{Q0, A, B, 1, QA}, {Q0, Bb, B, 1, QB}, {Q0, B, B, 0, TuringMachine::Accept},
+		{QA, A, A, 1, QA}, {QA, Bb, Bb, 1, QA}, {QA, B, B, -1, QA2},
+		{QA2, A, B, -1, Back}, {QA2, Bb, Bb, 0, TuringMachine::Reject}, {QA2, B, B, 0, TuringMachine::Accept},
+		{QB, A, A, 1, QB}, {QB, Bb, Bb, 1, QB}, {QB, B, B, -1, QB2},
+		{QB2, Bb, B, -1, Back}, {QB2, A, A, 0, TuringMachine::Reject}, {QB2, B, B, 0, TuringMachine::Accept},
+		{Back, A, A, -1, Back}, {Back, Bb, Bb, -1, Back}, {Back, B, B, 1, Q0},
+	}, {} };
+	for (std::size_t i = 0; i < word.size(); ++i) tm.input[static_cast<long long>(i)] = word[i] == 'a' ? A : Bb;
+	return tm;
+}
+
+// A chain of depth states each calling the next, entered calls times.
+ProgramFile<char8_t> CallChain(int depth, int calls) {
+	ProgramFile<char8_t> file;
+	for (int i = 0; i < depth; ++i) {
+		file.push_back(Line("name C" + Letters(i) + (i + 1 < depth ? " call C" + Letters(i + 1) : " right")));
+	}
+	for (int i = 0; i < calls; ++i) file.push_back(Line("call CA"));
+	return file;
+}
+
+// Walks far out on both sides of a one-cell tape writing ones, erases the outer half and shrinks the tape back.
+ProgramFile<char8_t> TapeGrowth(int strides, int stride) {
+	ProgramFile<char8_t> file;
+	for (int i = 1; i <= strides; ++i) file.push_back(Line("goto " + std::to_string(i * stride) + "; write 1"));
+	for (int i = 1; i <= strides; ++i) file.push_back(Line("goto -" + std::to_string(i * stride) + "; write 1"));
+	for (int i = strides / 2 + 1; i <= strides; ++i) file.push_back(Line("goto " + std::to_string(i * stride) + "; write 0; goto -" + std::to_string(i * stride) + "; write 0"));
+	file.push_back(Line("goto 0; shrink"));
+	return file;
+}
+
+struct Case {
+	std::string name;
+	ProgramFile<char8_t> program;
+	unsigned long tapeorder;
+	std::function<std::string(AbstractMachine&)> check; // an empty string when the machine got it right
+};
+
+Case TuringCase(const std::string& name, const TuringMachine& tm) {
+	Reference ref = Simulate(tm);
+	int k = Bits(tm.symbols);
+	return Case{ name, Compile(tm), 16, [ref, k](AbstractMachine& machine) -> std::string {
+		for (const auto& [cell, symbol] : ref.tape) {
+			if (Decode(machine, cell, k) != symbol) return "tape differs at cell " + std::to_string(cell);
+		}
+		if (machine.Tape->head != ref.head * k) return "head at " + std::to_string(machine.Tape->head) + ", expected " + std::to_string(ref.head * k);
+		if (machine.StateRegister->Accepting() != ref.accepted) return ref.accepted ? "rejected" : "accepted";
+		return "";
+	} };
+}
+
+std::vector<Case> Corpus() {
+	std::vector<Case> corpus;
+	corpus.push_back(TuringCase("busy-beaver-3", BusyBeaver3()));
+	corpus.push_back(TuringCase("busy-beaver-4", BusyBeaver4()));
+	corpus.push_back(TuringCase("binary-increment", BinaryIncrement(10)));
+	corpus.push_back(TuringCase("binary-add", BinaryAdd(0x5DEECE66DULL, 0xB16B00B5ULL, 40)));
+	corpus.push_back(TuringCase("unary-multiply", UnaryMultiply(8, 8)));
+	std::string word = "abbababbaabbbaababbaaababbab";
+	corpus.push_back(TuringCase("palindrome", Palindrome(word + std::string(word.rbegin(), word.rend()))));
+	corpus.push_back(TuringCase("palindrome-reject", Palindrome(word + "a" + word)));
+	corpus.push_back(Case{ "call-chain", CallChain(64, 200), 16, [](AbstractMachine& machine) -> std::string {
+		if (machine.stats.depth != 64) return "depth " + std::to_string(machine.stats.depth);
+		if (machine.Tape->head != 200) return "head " + std::to_string(machine.Tape->head);
+		return "";
+	} });
+	corpus.push_back(Case{ "tape-growth", TapeGrowth(200, 4099), 1, [](AbstractMachine& machine) -> std::string {
+		if (machine.stats.growths == 0 || machine.stats.shrinks != 1) return "tape did not grow and shrink";
+		std::size_t ones = 0;
+		for (std::size_t i = 0; i < machine.Tape->Tape.size(); ++i) ones += machine.Tape->Tape[i] ? 1 : 0;
+		if (ones != 200) return std::to_string(ones) + " ones";
+		return "";
+	} });
+	return corpus;
+}
+
+long PeakRSS() {
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss; // kilobytes on Linux
+}
+
+std::map<std::string, double> ReadBaseline(const std::string& path) {
+	std::map<std::string, double> baseline;
+	std::ifstream in(path);
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() || line[0] == '#') continue;
+		std::istringstream fields(line);
+		std::string name;
+		double ns;
+		if (fields >> name >> ns) baseline[name] = ns;
+	}
+	return baseline;
+}
+
+int main(int argc, char* argv[]) {
+	std::string baselinePath;
+	bool writeBaseline = false;
+	bool gate = false;
+	double tolerance = 0.25;
+	int reps = 5;
+	std::string only;
+	bool profile = false;
+	std::string foldedPath;
+	bool precompiled = false;
+	std::string cachePath;
+	bool accelerate = false;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--baseline" && i + 1 < argc) baselinePath = argv[++i];
+		else if (arg == "--write-baseline") writeBaseline = true;
+		else if (arg == "--gate") gate = true;
+		else if (arg == "--tolerance" && i + 1 < argc) tolerance = std::stod(argv[++i]);
+		else if (arg == "--reps" && i + 1 < argc) reps = std::stoi(argv[++i]);
+		else if (arg == "--only" && i + 1 < argc) only = argv[++i];
+		else if (arg == "--profile") profile = true;
+		else if (arg == "--folded" && i + 1 < argc) foldedPath = argv[++i];
+		else if (arg == "--precompiled") precompiled = true;
+		else if (arg == "--cache" && i + 1 < argc) cachePath = argv[++i];
+		else if (arg == "--accelerate") accelerate = true;
+		else {
+			std::cerr << "usage: benchmark [--baseline FILE] [--write-baseline] [--gate] [--tolerance FRACTION] [--reps N] [--only NAME] [--profile] [--folded FILE] [--precompiled] [--cache DIR] [--accelerate]\n";
+			return 2;
+		}
+	}
+
+	if (profile && !Profiling) {
+		std::cerr << "--profile needs a build with LANGUAGE_PROFILE=1\n";
+		return 2;
+	}
+
+	std::map<std::string, double> baseline;
+	if (!baselinePath.empty() && !writeBaseline) baseline = ReadBaseline(baselinePath);
+
+	std::cout << std::left << std::setw(20) << "program" << std::right
+		<< std::setw(12) << "steps" << std::setw(14) << "steps/sec" << std::setw(12) << "ns/step"
+		<< std::setw(10) << "growths" << std::setw(12) << "peak KB" << std::setw(12) << "baseline" << std::setw(10) << "change" << "\n";
+
+	std::ofstream folded;
+	if (!foldedPath.empty()) folded.open(foldedPath);
+
+	std::unique_ptr<ProgramCache> cache;
+	if (!cachePath.empty()) cache = std::make_unique<ProgramCache>(cachePath);
+
+	std::map<std::string, double> measured;
+	bool failed = false;
+	for (const Case& c : Corpus()) {
+		if (!only.empty() && c.name != only) continue;
+
+		// the best of reps runs, each on a fresh machine
+		double best = 0;
+		unsigned long long steps = 0, growths = 0;
+		std::string error;
+
+		std::unique_ptr<ProgramImage> image;
+		if (precompiled) {
+			std::string path = (std::filesystem::temp_directory_path() / ("benchmark-" + c.name + ".img")).string();
+			ProgramImage::Compile(c.program, path, c.tapeorder);
+			image = std::make_unique<ProgramImage>(path);
+			std::filesystem::remove(path); // the mapping stays valid
+		}
+		for (int r = 0; r < reps; ++r) {
+			AbstractMachine machine(c.tapeorder);
+			machine.Accelerate(accelerate);
+			CountSink counted;
+			ResultSink& sink = accelerate ? static_cast<ResultSink&>(machine.Discard) : counted; // steps are only replayed into a sink that drops results
+			auto begin = std::chrono::steady_clock::now();
+			if (image) {
+				image->Install(machine);
+				image->Run(machine, sink);
+			}
+			else if (cache) cache->LoadAndRun(machine, c.program, sink);
+			else machine.LoadAndRun(c.program, sink);
+			double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+
+			error = c.check(machine);
+			if (!error.empty()) break;
+			steps = machine.stats.instructions + machine.stats.simulated; // the steps replayed macro steps stand for count as run
+			growths = machine.stats.growths;
+			double perStep = ns / static_cast<double>(std::max<unsigned long long>(steps, 1));
+			if (r == 0 || perStep < best) best = perStep;
+
+			if (profile && r == reps - 1) {
+				std::cout << "machine language of " << c.name << "\n";
+				machine.language.WriteProfile(std::cout);
+				for (const auto& res : machine.Resources) {
+					std::cout << "resource language of " << c.name << "\n";
+					res->language.WriteProfile(std::cout);
+				}
+			}
+		}
+
+		if (!error.empty()) {
+			std::cout << std::left << std::setw(20) << c.name << " wrong result: " << error << "\n";
+			failed = true;
+			continue;
+		}
+
+		if (folded.is_open()) {
+			AbstractMachine machine(c.tapeorder);
+			machine.profile.Start(1);
+			machine.LoadAndRun(c.program, machine.Discard);
+			machine.profile.WriteFolded(folded, [&machine](unsigned long long st) { return machine.StateName(st); }, false, c.name);
+		}
+
+		measured[c.name] = best;
+		std::cout << std::left << std::setw(20) << c.name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(12) << steps << std::setw(14) << std::setprecision(0) << 1e9 / best << std::setw(12) << std::setprecision(1) << best
+			<< std::setw(10) << growths << std::setw(12) << PeakRSS();
+		if (baseline.contains(c.name)) {
+			double change = best / baseline[c.name] - 1.0;
+			std::cout << std::setw(12) << baseline[c.name] << std::setw(9) << std::showpos << change * 100 << "%" << std::noshowpos;
+			if (change > tolerance) {
+				std::cout << "  REGRESSION";
+				failed = true;
+			}
+		}
+		std::cout << "\n";
+	}
+	if (cache) std::cout << "program cache: " << cache->hits << " hits, " << cache->misses << " misses\n";
+
+	if (writeBaseline && !baselinePath.empty()) {
+		std::ofstream out(baselinePath);
+		out << "# program ns/step, written by benchmark --write-baseline\n";
+		for (const auto& [name, ns] : measured) out << name << " " << std::fixed << std::setprecision(1) << ns << "\n";
+	}
+
+	return gate && failed ? 1 : 0;
+}
@@ -0,0 +1,350 @@
+// Microbenchmark.cpp : Measures the parsing and dispatch primitives of Language.h one at a time.
+// Each primitive is swept over token length, alphabet size or the number of registered concepts, so the cost of the language layer can be followed as it grows.
+//
+// Usage: microbenchmark [--only PREFIX] [--time MILLISECONDS]
+// Output is tab separated, one row per measurement: benchmark, parameter, value, iterations, ns/op, allocs/op.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include "../Language.h"
+
+// Every allocation in the process goes through these, so allocs/op counts what the primitive itself allocates.
+static unsigned long long Allocations = 0;
+
+// The whole set is replaced, plain, array, sized and aligned, so every new is paired with the delete that frees what it got.
+static void* Allocate(std::size_t size) {
+	++Allocations;
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+static void* Allocate(std::size_t size, std::align_val_t alignment) {
+	++Allocations;
+	const std::size_t align = static_cast<std::size_t>(alignment);
+	if (void* p = std::aligned_alloc(align, (std::max(size, std::size_t(1)) + align - 1) / align * align)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return Allocate(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return Allocate(size, alignment); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+// Keeps the compiler from dropping a result that is never used.
+template <typename T>
+void Keep(const T& value) {
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Options {
+	std::string only;
+	double milliseconds = 50;
+};
+
+Options options;
+
+// Runs op in batches until the time budget is spent and prints the batch with the best ns/op.
+// ops is how many operations a single call of op stands for.
+template <typename Op>
+void Measure(const std::string& benchmark, const std::string& parameter, unsigned long long value, Op op, unsigned long long ops = 1) {
+	if (!options.only.empty() && benchmark.rfind(options.only, 0) != 0) return;
+
+	unsigned long long batch = 1;
+	double best = 0, allocs = 0;
+	unsigned long long iterations = 0;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(options.milliseconds);
+	do {
+		unsigned long long before = Allocations;
+		auto begin = std::chrono::steady_clock::now();
+		for (unsigned long long i = 0; i < batch; ++i) op();
+		double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+		double perOp = ns / static_cast<double>(batch * ops);
+		if (iterations == 0 || perOp < best) best = perOp;
+		allocs = static_cast<double>(Allocations - before) / static_cast<double>(batch * ops);
+		iterations += batch * ops;
+		if (ns < 1e6) batch *= 2; // grow the batch until one takes about a millisecond
+	} while (std::chrono::steady_clock::now() < deadline);
+
+	std::cout << benchmark << '\t' << parameter << '\t' << value << '\t' << iterations << '\t'
+		<< std::fixed << std::setprecision(2) << best << '\t' << allocs << '\n';
+}
+
+// A word of length n over the first size symbols of the printable alphabet.
+Medium<char8_t> Word(std::size_t n, std::size_t size = 26, std::size_t seed = 0) {
+	Medium<char8_t> word;
+	for (std::size_t i = 0; i < n; ++i) word += static_cast<char8_t>(u8'a' + (i * 7 + seed) % size);
+	return word;
+}
+
+// count words of length n separated by single spaces.
+Medium<char8_t> Sentence(std::size_t count, std::size_t n) {
+	Medium<char8_t> sentence;
+	for (std::size_t i = 0; i < count; ++i) {
+		if (i > 0) sentence += u8' ';
+		sentence += Word(n, 26, i);
+	}
+	return sentence;
+}
+
+// A distinct alphabetical name for every index: wa, wb, ..., wz, wba, wbb, ...
+Medium<char8_t> Name(std::size_t i) {
+	Medium<char8_t> name;
+	do {
+		name.insert(name.begin(), static_cast<char8_t>(u8'a' + i % 26));
+		i /= 26;
+	} while (i > 0);
+	return u8"w" + name;
+}
+
+const std::size_t Lengths[] = { 1, 4, 16, 64, 256, 1024 };
+const std::size_t Words = 16; // words per sentence for the tokenizers
+
+void Tokenizers() {
+	Language<char8_t> language;
+	for (std::size_t n : Lengths) {
+		const Medium<char8_t> sentence = Sentence(Words, n);
+		Measure("Munch", "length", n, [&]() {
+			Medium<char8_t> prog = sentence;
+			while (!prog.empty()) Keep(language.Munch(prog));
+		}, Words);
+		Measure("Lunch", "length", n, [&]() {
+			auto [token, consumed] = language.Lunch(sentence);
+			Keep(token);
+			Keep(consumed);
+		});
+		Measure("Chunkify", "length", n, [&]() {
+			Keep(language.Chunkify(sentence));
+		}, Words);
+	}
+}
+
+// Validating a line of ASCII, which takes the fast path, and a line with a two, three and four byte character in every word.
+void Encodings() {
+	for (std::size_t n : Lengths) {
+		const Medium<char8_t> ascii = Sentence(Words, n);
+		Medium<char8_t> mixed;
+		for (std::size_t i = 0; i < Words; ++i) mixed += Word(n, 26, i) + u8"é日𝄞 ";
+		Measure("Utf8/ascii", "length", n, [&]() { Keep(Utf8::Invalid(ascii)); });
+		Measure("Utf8/mixed", "length", n, [&]() { Keep(Utf8::Invalid(mixed)); });
+	}
+	const Token<char8_t> latin = Medium<char8_t>(u8"état"), ascii = Medium<char8_t>(u8"state");
+	Measure("str_name/ascii", "length", 5, [&]() { Keep(str_name(ascii)); });
+	Measure("str_name/latin", "length", 5, [&]() { Keep(str_name(latin)); });
+}
+
+void Alphabets() {
+	const std::size_t Sizes[] = { 2, 8, 26, 94 };
+	for (std::size_t size : Sizes) {
+		Language<char8_t> language;
+		Medium<char8_t> symbols;
+		for (std::size_t i = 0; i < size; ++i) symbols += static_cast<char8_t>(u8'!' + i);
+		language.AddSymbols(symbols);
+		for (std::size_t n : Lengths) {
+			Medium<char8_t> word;
+			for (std::size_t i = 0; i < n; ++i) word += symbols[(i * 7) % size];
+			const Token<char8_t> token = word;
+			Measure("is_word/alphabet=" + std::to_string(size), "length", n, [&]() { Keep(language.is_word(token)); });
+		}
+	}
+}
+
+// Building a character class from a ctype predicate, and composing two.
+void Classes() {
+	Measure("CharClass/predicate", "bytes", 256, [&]() { Keep(GetCharacterSet(std::isalnum)); });
+	const CharClass alpha = GetCharacterSet(std::isalpha), digit = GetCharacterSet(std::isdigit);
+	Measure("CharClass/union", "bytes", 256, [&]() { Keep(Union(alpha, digit)); });
+	Measure("CharClass/inclusion", "bytes", 256, [&]() { Keep(Inclusion(alpha, digit)); });
+	Measure("Language/character-interpretations", "concepts", 12, [&]() {
+		Language<char8_t> language;
+		language.AddCharacterInterpretations();
+		Keep(language.I.size());
+	});
+}
+
+// Tries a token against a language holding count named concepts, for a token that is never recognized and for the concept registered first, both of which are tried last.
+void Interpretations() {
+	const std::size_t Counts[] = { 1, 10, 100, 1000 };
+	for (std::size_t count : Counts) {
+		Language<char8_t> language;
+		for (std::size_t i = 0; i < count; ++i) language.Interpret(Name(i), std::any(i));
+		const Token<char8_t> miss = Medium<char8_t>(u8"unregistered");
+		const Token<char8_t> first = Name(0);
+		Measure("has_interpretation/miss", "concepts", count, [&]() { Keep(language.has_interpretation(miss)); });
+		Measure("has_interpretation/first", "concepts", count, [&]() { Keep(language.has_interpretation(first)); });
+	}
+
+	// A digit string falls through to the character classes every resource language starts with.
+	Language<char8_t> language;
+	language.AddCharacterInterpretations();
+	const Token<char8_t> digits = Medium<char8_t>(u8"12345");
+	Measure("has_interpretation/literal", "concepts", language.I.size(), [&]() { Keep(language.has_interpretation(digits)); });
+}
+
+// Decoding an instruction in a machine: a machine command, resource commands with and without the resource name, a literal, which every language is tried for,
+// and a write without a value, which its syntax rejects.
+void Decodes() {
+	AbstractMachine machine;
+	const std::pair<std::string, Medium<char8_t>> instructions[] = {
+		{ "machine", u8"jump SA" }, { "resource", u8"left" }, { "resource/operand", u8"write 1" }, { "resource/prefixed", u8"tape left" }, { "literal", u8"12345" },
+		{ "malformed", u8"write" },
+	};
+	for (const auto& [kind, text] : instructions) {
+		const Token<char8_t> instruction = text;
+		Measure("Decode/" + kind, "length", text.size(), [&]() { Keep(machine.Decode(instruction)); });
+	}
+}
+
+// Recognizing and calling "add 2 3" registered from a signature, and the same function registered as a Medium function that reads its own arguments.
+void Functions() {
+	Language<char8_t> language;
+	language.AddCharacterInterpretations();
+	language.InterpretFunction(u8"add", { u8"add" }, std::function<int(int, int)>([](int a, int b) { return a + b; }));
+	language.InterpretMediumFunction(u8"sum", { u8"sum" }, [&language](const Medium<char8_t>& prog) -> std::any {
+		ProgramFile<char8_t> words = language.Chunkify(prog);
+		return std::stoi(std::string(words[1].begin(), words[1].end())) + std::stoi(std::string(words[2].begin(), words[2].end()));
+	});
+	const Token<char8_t> typed = Medium<char8_t>(u8"add 2 3"), medium = Medium<char8_t>(u8"sum 2 3");
+	auto call = [&language](const Token<char8_t>& prog) {
+		auto match = language.Recognize(prog);
+		Keep(language.Evaluate(*match->first, prog, match->second.operands).has_value());
+	};
+	Measure("Function/typed", "arguments", 2, [&]() { call(typed); });
+	Measure("Function/medium", "arguments", 2, [&]() { call(medium); });
+}
+
+void Characters() {
+	for (std::size_t n : Lengths) {
+		const Token<char8_t> upper = Medium<char8_t>(n, u8'A');
+		const Token<char8_t> digits = Medium<char8_t>(n, u8'7');
+		Measure("ToLower", "length", n, [&]() { Keep(ToLower(upper)); });
+		Measure("str_predicate/isdigit", "length", n, [&]() { Keep(str_predicate(std::isdigit, digits)); });
+	}
+}
+
+// WriteSyntax on the substrate of each tape type, for an accepted value and a command that is not a write, and the write as a whole.
+template <Value V>
+void Write(const std::string& type, const Medium<char8_t>& value) {
+	Substrate<V> substrate;
+	const Token<char8_t> write = Medium<char8_t>(u8"write " + value);
+	const Token<char8_t> other = Medium<char8_t>(u8"right");
+	Measure("WriteSyntax/" + type, "value", value.size(), [&]() { Keep(substrate.WriteSyntax(write)); });
+	Measure("WriteSyntax/" + type + "/other", "value", 0, [&]() { Keep(substrate.WriteSyntax(other)); });
+	// A whole write, recognized and evaluated with the value its syntax parsed, and evaluated without it, which parses the value again.
+	Measure("Write/" + type, "value", value.size(), [&]() {
+		auto match = substrate.language.Recognize(write);
+		Keep(substrate.language.Evaluate(*match->first, write, match->second.operands).has_value());
+	});
+	Measure("Write/" + type + "/reparsed", "value", value.size(), [&]() {
+		auto match = substrate.language.Recognize(write);
+		Keep(substrate.language.Evaluate(*match->first, write).has_value());
+	});
+}
+
+// Finding the next 1 a distance away, with the scans and with a right and read per cell as programs did before them.
+void Scans() {
+	for (std::size_t n : Lengths) {
+		Substrate<bool> tape;
+		tape.NewTape(12);
+		tape.GoTo(static_cast<long long>(n));
+		tape.Write(true);
+		Measure("Seek", "distance", n, [&]() {
+			tape.head = 0;
+			Keep(tape.Seek(true));
+		});
+		Measure("Seek/right-read", "distance", n, [&]() {
+			tape.head = 0;
+			do tape.Right(); while (!tape.Read());
+		});
+		Measure("Count", "cells", n, [&]() { Keep(tape.Count(true, 0, static_cast<long long>(n))); });
+		Measure("Find", "distance", n, [&]() {
+			tape.head = -1;
+			Keep(tape.Find({ false, true }));
+		});
+	}
+}
+
+// Adding a constant to n cells and summing them, in one range operation and a cell at a time.
+void Ranges() {
+	for (std::size_t n : Lengths) {
+		Substrate<int> tape;
+		tape.NewTape(12);
+		const long long last = static_cast<long long>(n) - 1;
+		Measure("Apply/add", "cells", n, [&]() { Keep(tape.Apply(Substrate<int>::Operation::Add, 1, 0, last)); });
+		Measure("Apply/add/cell-by-cell", "cells", n, [&]() {
+			for (long long c = 0; c <= last; ++c) {
+				tape.GoTo(c);
+				tape.Write(tape.Read() + 1);
+			}
+		});
+		Measure("Sum", "cells", n, [&]() { Keep(tape.Sum(0, last)); });
+		Measure("Scan", "cells", n, [&]() { Keep(tape.Scan(0, last)); });
+	}
+}
+
+// The configuration hash kept up to date by writes, against hashing the whole tape again, on a tape of n cells, every other one written.
+void Hashes() {
+	for (std::size_t n : Lengths) {
+		Substrate<bool> tape;
+		tape.NewTape(static_cast<unsigned char>(std::max<std::size_t>(1, std::bit_width(n) - 1)));
+		tape.Hash();
+		for (long long c = -static_cast<long long>(n) / 2; c < static_cast<long long>(n) / 2; c += 2) tape.Put(c, true);
+		Measure("Hash/write", "cells", n, [&]() {
+			tape.Write(!tape.Read());
+			Keep(tape.Hash());
+		});
+		Measure("Hash/rehash", "cells", n, [&]() {
+			tape.Write(!tape.Read());
+			tape.Rehash();
+			Keep(tape.Hash());
+		});
+	}
+}
+
+void Writes() {
+	Write<bool>("bool", u8"true");
+	Write<char8_t>("char8_t", u8"x");
+	Write<char>("char", u8"65");
+	Write<int>("int", u8"123456");
+	Write<double>("double", u8"3.14159");
+	Write<std::u8string>("u8string", Word(64));
+}
+
+int main(int argc, char* argv[]) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--only" && i + 1 < argc) options.only = argv[++i];
+		else if (arg == "--time" && i + 1 < argc) options.milliseconds = std::stod(argv[++i]);
+		else {
+			std::cerr << "usage: microbenchmark [--only PREFIX] [--time MILLISECONDS]\n";
+			return 2;
+		}
+	}
+
+	std::cout << "benchmark\tparameter\tvalue\titerations\tns/op\tallocs/op\n";
+	Tokenizers();
+	Encodings();
+	Alphabets();
+	Classes();
+	Interpretations();
+	Decodes();
+	Functions();
+	Characters();
+	Scans();
+	Ranges();
+	Hashes();
+	Writes();
+	return 0;
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <coroutine>
+#include <chrono>
+#include <exception>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+
+#include "Language.h"
+
+// Resumable is what a Scheduler runs: work done a slice at a time.
+class Resumable {
+public:
+	enum class Status { Ready, Suspended, Done, Cancelled, Failed };
+
+	virtual ~Resumable() = default;
+
+	// Runs at most budget instructions, and for at most time if time is non-zero.
+	virtual Status Resume(unsigned long long budget, std::chrono::microseconds time = std::chrono::microseconds::zero()) = 0;
+	virtual bool Finished() const = 0;
+};
+
+// An Execution runs a program on a machine a slice at a time.
+// Each call to Resume evaluates instructions until the program ends, the step budget is spent or the time budget runs out, and then yields back to the caller.
+// Called states and the programs of run commands run as frames of the execution, so every instruction counts against the budget,
+// a slice can stop anywhere in them and pick up from there later, and instructions run in the order Run would evaluate them.
+// Decoded programs are evaluated from their instructions, and macro steps are taken as Run takes them; a step being recorded when a slice ends is given up.
+// A machine may have at most one live Execution: its calls are pushed onto the machine's state register, so two unfinished executions of one machine
+// would unwind each other's. Resuming an execution while another runs on its machine throws.
+template <Value V>
+class BasicExecution : public Resumable {
+public:
+	using Frame = typename BasicMachine<V>::Frame;
+
+	// The coroutine that does the work. It suspends before running anything and whenever the budget of a slice is spent.
+	struct Routine {
+		struct promise_type {
+			std::exception_ptr error;
+
+			Routine get_return_object() { return Routine{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { error = std::current_exception(); }
+		};
+
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	BasicMachine<V>& machine;
+	ResultSink* sink;
+	std::vector<Frame> frames;
+
+	Status status = Status::Ready;
+	std::exception_ptr error;
+	std::atomic<bool> cancelled = false;
+
+	unsigned long long steps = 0; // instructions evaluated by this execution
+
+	// The clock is only read every Tick steps, so a time budget may be overrun by fewer than Tick instructions.
+	static constexpr unsigned long long Tick = 64;
+
+	BasicExecution(BasicMachine<V>& m, const Token<char8_t>& program, ResultSink& s) : machine(m), sink(&s) {
+		Enter(machine.LoadState(program));
+		routine = Run();
+	}
+
+	BasicExecution(BasicMachine<V>& m, const Token<char8_t>& program) : BasicExecution(m, program, m.Discard) {}
+
+	// Loads every line of the file and runs the ones that do not name a state, in order, as LoadAndRun does.
+	BasicExecution(BasicMachine<V>& m, const ProgramFile<char8_t>& file, ResultSink& s) : machine(m), sink(&s) {
+		std::vector<unsigned long long> StateStack;
+		for (const Medium<char8_t>& line : file) {
+			StateStack.push_back(machine.LoadState(line));
+		}
+		for (auto st = StateStack.rbegin(); st != StateStack.rend(); ++st) {
+			if (!machine.StateRegister->named.contains(*st)) Enter(*st);
+		}
+		routine = Run();
+	}
+
+	BasicExecution(BasicMachine<V>& m, const ProgramFile<char8_t>& file) : BasicExecution(m, file, m.Discard) {}
+
+	BasicExecution(const BasicExecution&) = delete;
+	BasicExecution& operator=(const BasicExecution&) = delete;
+
+	// An execution dropped before it finished is unwound as a cancelled one is, unless its machine is running another, which a destructor cannot throw for.
+	~BasicExecution() override {
+		if (!Finished() && !frames.empty() && machine.Frames == nullptr) {
+			Attach();
+			Finish(Status::Cancelled);
+			Detach();
+		}
+		if (routine.handle) routine.handle.destroy();
+	}
+
+	// Exceptions thrown by the program leave the execution Failed with the exception in error.
+	// Resuming it while another execution runs on its machine throws std::logic_error and leaves it as it was.
+	Status Resume(unsigned long long budget, std::chrono::microseconds time = std::chrono::microseconds::zero()) override {
+		if (Finished()) return status;
+
+		stepbudget = steps + budget;
+		deadline = time.count() > 0 ? std::chrono::steady_clock::now() + time : std::chrono::steady_clock::time_point::max();
+
+		Attach();
+		if (cancelled) Finish(Status::Cancelled);
+		else {
+			{
+				Statistics::Timer timer(machine.stats, Statistics::Phase::Run);
+				routine.handle.resume();
+			}
+			if (routine.handle.done()) {
+				if (routine.handle.promise().error) {
+					error = routine.handle.promise().error;
+					Finish(Status::Failed);
+				}
+				else Finish(cancelled ? Status::Cancelled : Status::Done);
+			}
+			else status = Status::Suspended;
+		}
+		Detach();
+		return status;
+	}
+
+	// Runs to completion, one slice of budget instructions at a time.
+	Status Complete(unsigned long long budget = 1024) {
+		while (Resume(budget) == Status::Suspended) {}
+		if (status == Status::Failed) std::rethrow_exception(error);
+		return status;
+	}
+
+	// Stops the execution before its next instruction. Safe to call from another thread while it runs.
+	void Cancel() { cancelled = true; }
+
+	bool Finished() const override { return status == Status::Done || status == Status::Cancelled || status == Status::Failed; }
+
+	long long Head() const { return machine.Tape->head; }
+	unsigned long long State() const { return machine.StateRegister->state; }
+	unsigned long long Count() const { return machine.StateRegister->icount; }
+
+private:
+	Routine routine;
+	unsigned long long stepbudget = 0;
+	std::chrono::steady_clock::time_point deadline;
+	ResultSink* outer = nullptr;
+
+	void Enter(unsigned long long st) {
+		if (machine.StateRegister->states.contains(st)) {
+			frames.push_back(Frame{ st, std::get<Medium<char8_t>>(machine.StateRegister->states[st]), 0, false, machine.StateRegister->Decoded(st), 0, machine.StateRegister->edits });
+		}
+	}
+
+	// Hands the frames to the machine for the length of a slice. Each frame is a level of Run to the macro steps.
+	void Attach() {
+		if (machine.Frames != nullptr) throw std::logic_error("The machine is already running an execution\n");
+		outer = machine.Sink;
+		machine.Sink = sink;
+		machine.Frames = &frames;
+		machine.macros.depth += static_cast<unsigned>(frames.size());
+	}
+
+	void Detach() {
+		machine.macros.Drop();
+		machine.macros.depth -= static_cast<unsigned>(frames.size());
+		machine.Frames = nullptr;
+		machine.Sink = outer;
+	}
+
+	bool Exhausted() const {
+		if (steps >= stepbudget) return true;
+		if (deadline == std::chrono::steady_clock::time_point::max() || steps % Tick != 0) return false;
+		return std::chrono::steady_clock::now() >= deadline;
+	}
+
+	// Unwinds the frames still open so the state register is left as it was before the execution.
+	void Finish(Status s) {
+		while (!frames.empty()) machine.PopFrame();
+		status = s;
+	}
+
+	Routine Run() {
+		while (!frames.empty()) {
+			if (cancelled) co_return;
+			if (Exhausted()) co_await std::suspend_always{};
+			if (cancelled) co_return;
+
+			// An instruction may push a frame, for a call or a run, so hold on to an index and not a reference.
+			std::size_t top = frames.size() - 1;
+			if (frames[top].code != nullptr && frames[top].edits != machine.StateRegister->edits) frames[top].code = nullptr; // may be gone; carry on from the text
+			if (frames[top].code != nullptr) {
+				if (frames[top].next == frames[top].code->size()) {
+					machine.PopFrame();
+					continue;
+				}
+				const Instruction instruction = (*frames[top].code)[frames[top].next++]; // a copy, as the instruction may redefine its own state
+				frames[top].pos = instruction.begin + machine.Execute(instruction, frames[top].program, *sink);
+			}
+			else {
+				const Medium<char8_t>& prog = frames[top].program;
+				std::size_t pos = BasicMachine<V>::Next(prog, frames[top].pos);
+				if (pos == prog.size()) {
+					machine.PopFrame();
+					continue;
+				}
+
+				std::size_t end = BasicMachine<V>::Separator(prog, pos);
+				unsigned long long consumed = machine.Step(*machine.arena.Acquire(prog.begin() + pos, prog.begin() + end), *sink);
+				if (consumed == 0) {
+					throw std::invalid_argument("Unconsumed input remaining after evaluation\n");
+				}
+				frames[top].pos = pos + consumed;
+			}
+			++steps;
+
+			if (machine.Jumped) {
+				machine.Jumped = false;
+				if (machine.macros.on && !sink->Keeps()) machine.MacroStep();
+				Frame& frame = frames[top];
+				frame.state = machine.StateRegister->state;
+				const Medium<char8_t>& text = std::get<Medium<char8_t>>(machine.StateRegister->states[frame.state]);
+				frame.program.assign(text.begin(), text.end());
+				frame.code = machine.StateRegister->Decoded(frame.state);
+				frame.edits = machine.StateRegister->edits;
+				frame.pos = frame.next = 0;
+			}
+		}
+	}
+};
+
+using Execution = BasicExecution<bool>;
+
+
+// A Scheduler multiplexes many executions over a small pool of threads.
+// Each worker takes the execution at the front of the queue, resumes it for one slice and puts it at the back if it is not finished, so no machine can hold a thread for longer than a slice.
+// An execution is only ever resumed by one worker at a time. Two executions of one machine must not be submitted, as workers would resume them at once.
+// Destroying the scheduler lets every execution submitted to it finish first; cancel the ones that should not run to the end.
+class Scheduler {
+public:
+	unsigned long long budget; // instructions per slice
+	std::chrono::microseconds slice; // time per slice
+
+	Scheduler(unsigned threads = std::thread::hardware_concurrency(), unsigned long long steps = 1024, std::chrono::microseconds time = std::chrono::microseconds(1000))
+		: budget(steps), slice(time) {
+		if (threads == 0) threads = 1;
+		for (unsigned i = 0; i < threads; ++i) {
+			workers.emplace_back([this]() { Work(); });
+		}
+	}
+
+	Scheduler(const Scheduler&) = delete;
+	Scheduler& operator=(const Scheduler&) = delete;
+
+	~Scheduler() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		ready.notify_all();
+		for (auto& w : workers) w.join();
+	}
+
+	void Submit(std::shared_ptr<Resumable> e) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(std::move(e));
+			++pending;
+		}
+		ready.notify_one();
+	}
+
+	// Blocks until every submitted execution has finished.
+	void Wait() {
+		std::unique_lock<std::mutex> lock(mutex);
+		idle.wait(lock, [this]() { return pending == 0; });
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::shared_ptr<Resumable>> queue;
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::condition_variable idle;
+	unsigned long long pending = 0;
+	bool stopping = false;
+
+	void Work() {
+		while (true) {
+			std::shared_ptr<Resumable> e;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				ready.wait(lock, [this]() { return stopping || !queue.empty(); });
+				if (queue.empty()) return; // stopping, and what is left is being resumed by workers that carry it on
+				e = std::move(queue.front());
+				queue.pop_front();
+			}
+
+			e->Resume(budget, slice);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (e->Finished()) {
+					if (--pending == 0) idle.notify_all();
+				}
+				else {
+					queue.push_back(std::move(e));
+					ready.notify_one();
+				}
+			}
+		}
+	}
+};
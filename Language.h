@@ -14,6 +14,10 @@
 #include <concepts>
 #include <typeinfo>
 #include <variant>
+#include <optional>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
 #include <stdexcept>
 #include <cctype>
 #include <algorithm>
@@ -24,6 +28,18 @@
 #include <charconv>
 #include <string_view>
 #include <unordered_map>
+#include <sstream>
+#include <mutex>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <thread>
+#include <deque>
+#include <array>
+#include <expected>
+#include <tuple>
+
+#include "Unicode.h"
 
 
 
@@ -216,9 +232,449 @@ using ProgramFile = std::vector<Medium<V>>;
 //	}
 //};
 
+// A Symbol is a letter of an alphabet of N symbols, 0 up to N - 1, written as one digit or letter: 0 to 9, then a to z.
+// It lets a machine with a few symbols keep one on each cell, instead of spelling each in several bool cells.
+template <unsigned N>
+	requires (N >= 2 && N <= 36)
+struct Symbol {
+	using inner_type = unsigned char;
+	inner_type value = 0;
+
+	Symbol() = default;
+	Symbol(inner_type v) : value(v) {}
+
+	explicit Symbol(const std::u8string& text) {
+		std::optional<Symbol> symbol = From(text);
+		if (!symbol) throw std::invalid_argument("Not a symbol of an alphabet of " + std::to_string(N) + "\n");
+		value = symbol->value;
+	}
+
+	// The symbol text spells, if it spells one. Parsing a tape value goes through this, so a bad value costs no exception.
+	static std::optional<Symbol> From(const std::u8string& text) noexcept {
+		unsigned v = N;
+		if (text.size() == 1) {
+			char8_t c = text[0];
+			if (c >= u8'0' && c <= u8'9') v = c - u8'0';
+			else if (c >= u8'a' && c <= u8'z') v = c - u8'a' + 10;
+			else if (c >= u8'A' && c <= u8'Z') v = c - u8'A' + 10;
+		}
+		if (v >= N) return std::nullopt;
+		return Symbol(static_cast<inner_type>(v));
+	}
+
+	operator inner_type() const { return value; }
+	bool operator==(const Symbol&) const = default;
+
+	char Glyph() const { return "0123456789abcdefghijklmnopqrstuvwxyz"[value]; }
+};
+
+// PackedCells is the tape of an alphabet of at most 2^Bits symbols, 64 / Bits cells to a word.
+// Cells are read and written through operator[], and scanned a word at a time.
+template <unsigned Bits>
+	requires (Bits == 2 || Bits == 4)
+class PackedCells {
+public:
+	using value_type = unsigned char;
+	static constexpr std::size_t PerWord = 64 / Bits;
+	static constexpr std::uint64_t Mask = (std::uint64_t(1) << Bits) - 1;
+	static constexpr std::uint64_t Ones = ~std::uint64_t(0) / Mask; // the low bit of every cell
+	static constexpr std::uint64_t Low = Ones * (Mask >> 1); // every bit of every cell but the top one
+
+	class reference {
+	public:
+		reference(std::uint64_t& w, unsigned s) : word(&w), shift(s) {}
+		operator value_type() const { return static_cast<value_type>((*word >> shift) & Mask); }
+		reference& operator=(value_type v) {
+			*word = (*word & ~(Mask << shift)) | ((static_cast<std::uint64_t>(v) & Mask) << shift);
+			return *this;
+		}
+		reference& operator=(const reference& other) { return *this = static_cast<value_type>(other); }
+
+	private:
+		std::uint64_t* word;
+		unsigned shift;
+	};
+
+	PackedCells() = default;
+	PackedCells(std::size_t size, value_type init = 0) : words((size + PerWord - 1) / PerWord, Ones * (init & Mask)), cells(size) {}
+
+	std::size_t size() const { return cells; }
+
+	static std::size_t Bytes(std::size_t n) { return (n + PerWord - 1) / PerWord * sizeof(std::uint64_t); }
+
+	reference operator[](std::size_t i) { return reference(words[i / PerWord], static_cast<unsigned>(i % PerWord) * Bits); }
+	value_type operator[](std::size_t i) const { return static_cast<value_type>((words[i / PerWord] >> ((i % PerWord) * Bits)) & Mask); }
+
+	// The first cell in [from, to) holding symbol, or to.
+	std::size_t Next(std::size_t from, std::size_t to, value_type symbol) const {
+		for (std::size_t w = from / PerWord; from < to && w * PerWord < to; ++w) {
+			if (std::uint64_t m = Matches(w, symbol, from, to)) return w * PerWord + static_cast<std::size_t>(std::countr_zero(m)) / Bits;
+		}
+		return to;
+	}
+
+	// The last cell in [from, to) holding symbol, or to.
+	std::size_t Previous(std::size_t from, std::size_t to, value_type symbol) const {
+		if (from >= to) return to;
+		for (std::size_t w = (to - 1) / PerWord + 1; w-- > from / PerWord; ) {
+			if (std::uint64_t m = Matches(w, symbol, from, to)) return w * PerWord + static_cast<std::size_t>(63 - std::countl_zero(m)) / Bits;
+		}
+		return to;
+	}
+
+	// The cells in [from, to) holding symbol.
+	std::size_t Count(std::size_t from, std::size_t to, value_type symbol) const {
+		std::size_t n = 0;
+		for (std::size_t w = from / PerWord; from < to && w * PerWord < to; ++w) n += static_cast<std::size_t>(std::popcount(Matches(w, symbol, from, to)));
+		return n;
+	}
+
+private:
+	std::vector<std::uint64_t> words;
+	std::size_t cells = 0;
+
+	// The cells of word w in [from, to) holding symbol, as the top bit of each.
+	std::uint64_t Matches(std::size_t w, value_type symbol, std::size_t from, std::size_t to) const {
+		std::uint64_t x = words[w] ^ (Ones * symbol);
+		std::uint64_t m = ~(((x & Low) + Low) | x | Low);
+		std::size_t first = w * PerWord;
+		if (from > first) m &= ~std::uint64_t(0) << ((from - first) * Bits);
+		if (to < first + PerWord) m &= ~std::uint64_t(0) >> (64 - (to - first) * Bits);
+		return m;
+	}
+};
+
+// Alphabets of up to 4 symbols take 2 bits a cell, up to 16 take 4; larger ones a byte.
+template <unsigned N>
+	requires (N <= 16)
+struct MediumHelper<Symbol<N>> {
+	using type = PackedCells<(N <= 4 ? 2 : 4)>;
+};
+
+// Fields lists the data members of a Defined symbol type, for a user who wants its tape stored a column per member:
+//
+//   template <> struct Fields<Cell> { static constexpr auto members = std::make_tuple(&Cell::colour, &Cell::mark); };
+//
+// The members must be every member of the type, so a symbol can be rebuilt from its columns.
+template <typename V>
+struct Fields {};
+
+template <typename V>
+concept Columnar = requires { Fields<V>::members; };
+
+template <typename M>
+struct MemberOf;
+
+template <typename C, typename T>
+struct MemberOf<T C::*> {
+	using type = T;
+};
+
+// Columns is the tape of a Columnar type V: a vector per member rather than a vector of V, so a scan over one member reads only that member.
+// Cells are read and written whole through operator[], which gathers and scatters the members; Column gives one member's column for bulk work.
+template <typename V, typename = std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<decltype(Fields<V>::members)>>>>
+class Columns;
+
+template <typename V, std::size_t... I>
+class Columns<V, std::index_sequence<I...>> {
+	static constexpr auto members = Fields<V>::members;
+
+public:
+	template <std::size_t K>
+	using Field = typename MemberOf<std::remove_cvref_t<decltype(std::get<K>(members))>>::type;
+
+	using value_type = V;
+
+	class reference {
+	public:
+		reference(Columns& c, std::size_t i) : tape(&c), cell(i) {}
+		operator V() const { return tape->Get(cell); }
+		reference& operator=(const V& v) {
+			tape->Set(cell, v);
+			return *this;
+		}
+		reference& operator=(const reference& other) { return *this = static_cast<V>(other); }
+		bool operator==(const V& v) const { return tape->Matches(cell, v); }
+
+	private:
+		Columns* tape;
+		std::size_t cell;
+	};
+
+	Columns() = default;
+	explicit Columns(std::size_t size, const V& init = V{}) : columns(std::vector<Field<I>>(size, init.*std::get<I>(members))...), cells(size) {}
+
+	std::size_t size() const { return cells; }
+
+	static std::size_t Bytes(std::size_t n) { return n * (sizeof(Field<I>) + ...); }
+
+	reference operator[](std::size_t i) { return reference(*this, i); }
+	V operator[](std::size_t i) const { return Get(i); }
+
+	V Get(std::size_t i) const {
+		V v{};
+		((v.*std::get<I>(members) = std::get<I>(columns)[i]), ...);
+		return v;
+	}
+
+	void Set(std::size_t i, const V& v) {
+		((std::get<I>(columns)[i] = v.*std::get<I>(members)), ...);
+	}
+
+	bool Matches(std::size_t i, const V& v) const {
+		return ((std::get<I>(columns)[i] == v.*std::get<I>(members)) && ...);
+	}
+
+	template <std::size_t K>
+	std::vector<Field<K>>& Column() { return std::get<K>(columns); }
+
+	template <std::size_t K>
+	const std::vector<Field<K>>& Column() const { return std::get<K>(columns); }
+
+	// Copies n cells of other, from source on, to the cells from target on, a column at a time.
+	void Copy(std::size_t target, const Columns& other, std::size_t source, std::size_t n) {
+		(std::copy_n(std::get<I>(other.columns).begin() + static_cast<std::ptrdiff_t>(source), n, std::get<I>(columns).begin() + static_cast<std::ptrdiff_t>(target)), ...);
+	}
+
+	// The first cell in [from, to) holding v, or to. Candidates are found in the first column and checked against the others.
+	std::size_t Next(std::size_t from, std::size_t to, const V& v) const {
+		const auto& first = std::get<0>(columns);
+		const auto field = v.*std::get<0>(members);
+		for (std::size_t i = from; i < to; ++i) {
+			i = static_cast<std::size_t>(std::find(first.begin() + static_cast<std::ptrdiff_t>(i), first.begin() + static_cast<std::ptrdiff_t>(to), field) - first.begin());
+			if (i < to && Matches(i, v)) return i;
+		}
+		return to;
+	}
+
+	// The last cell in [from, to) holding v, or to.
+	std::size_t Previous(std::size_t from, std::size_t to, const V& v) const {
+		const auto& first = std::get<0>(columns);
+		const auto field = v.*std::get<0>(members);
+		for (std::size_t i = to; i > from; ) {
+			if (first[--i] == field && Matches(i, v)) return i;
+		}
+		return to;
+	}
+
+	// The cells in [from, to) holding v.
+	std::size_t Count(std::size_t from, std::size_t to, const V& v) const {
+		const auto& first = std::get<0>(columns);
+		const auto field = v.*std::get<0>(members);
+		std::size_t n = 0;
+		for (std::size_t i = from; i < to; ++i) n += first[i] == field && Matches(i, v);
+		return n;
+	}
+
+	// The first and last cells that differ from v, a column at a time, or size() and 0 when every cell holds v.
+	std::pair<std::size_t, std::size_t> Occupied(const V& v) const {
+		std::size_t lowest = cells, highest = 0;
+		auto column = [&](const auto& c, const auto& field) {
+			for (std::size_t i = 0; i < lowest; ++i) {
+				if (!(c[i] == field)) { lowest = i; break; }
+			}
+			for (std::size_t i = cells; i > highest && i > 0; --i) {
+				if (!(c[i - 1] == field)) { highest = std::max(highest, i - 1); break; }
+			}
+		};
+		(column(std::get<I>(columns), v.*std::get<I>(members)), ...);
+		return { lowest, highest };
+	}
+
+private:
+	std::tuple<std::vector<Field<I>>...> columns;
+	std::size_t cells = 0;
+};
+
+// A Columnar symbol type is stored in Columns.
+template <Value V>
+	requires (!HasInner<V> && Columnar<V>)
+struct MediumHelper<V> {
+	using type = Columns<V>;
+};
+
+// A StringPool keeps one copy of every string written to a tape and hands out a 32-bit handle for it. Handle 0 is the empty string, the blank.
+template <String S>
+class StringPool {
+public:
+	using View = std::basic_string_view<typename S::value_type>;
+
+	StringPool() { texts.emplace_back(); }
+
+	std::uint32_t Intern(const S& text) {
+		if (text.empty()) return 0;
+		auto found = handles.find(View(text));
+		if (found != handles.end()) return found->second;
+		if (texts.size() > std::numeric_limits<std::uint32_t>::max()) throw std::overflow_error("String pool full");
+		std::uint32_t handle = static_cast<std::uint32_t>(texts.size());
+		texts.push_back(text);
+		handles.emplace(View(texts.back()), handle); // a deque does not move its strings, so the view stays good
+		return handle;
+	}
+
+	// The handle of text, if it has been interned.
+	std::optional<std::uint32_t> Find(const S& text) const {
+		if (text.empty()) return 0;
+		auto found = handles.find(View(text));
+		if (found == handles.end()) return std::nullopt;
+		return found->second;
+	}
+
+	const S& Text(std::uint32_t handle) const { return texts[handle]; }
+
+	std::size_t size() const { return texts.size(); }
+
+private:
+	std::deque<S> texts;
+	std::unordered_map<View, std::uint32_t> handles;
+};
+
+// InternedCells is the tape of a string type: a handle per cell into a StringPool shared with the tapes it was grown or shrunk from.
+// Growing, shrinking and scanning move and compare handles, and writing a string the tape already holds allocates nothing.
+// The pool keeps every string written until the tape is replaced by NewTape.
+template <String S>
+class InternedCells {
+public:
+	using value_type = S;
+
+	class reference {
+	public:
+		reference(InternedCells& c, std::size_t i) : tape(&c), cell(i) {}
+		operator const S&() const { return tape->pool->Text(tape->handles[cell]); }
+		reference& operator=(const S& text) {
+			tape->handles[cell] = tape->pool->Intern(text);
+			return *this;
+		}
+		reference& operator=(const reference& other) {
+			if (tape->pool == other.tape->pool) tape->handles[cell] = other.tape->handles[other.cell];
+			else *this = static_cast<const S&>(other);
+			return *this;
+		}
+		bool operator==(const S& text) const { return static_cast<const S&>(*this) == text; }
+
+	private:
+		InternedCells* tape;
+		std::size_t cell;
+	};
+
+	InternedCells() : pool(std::make_shared<StringPool<S>>()) {}
+	InternedCells(std::size_t size, const S& init = S{}) : pool(std::make_shared<StringPool<S>>()) {
+		handles.assign(size, pool->Intern(init));
+	}
+
+	std::size_t size() const { return handles.size(); }
+
+	static std::size_t Bytes(std::size_t n) { return n * sizeof(std::uint32_t); }
+
+	reference operator[](std::size_t i) { return reference(*this, i); }
+	const S& operator[](std::size_t i) const { return pool->Text(handles[i]); }
+
+	std::uint32_t Handle(std::size_t i) const { return handles[i]; }
+	const StringPool<S>& Pool() const { return *pool; }
+
+	// Copies n cells of other, from source on, to the cells from target on. A tape that has only ever held blanks takes over the other's pool.
+	void Copy(std::size_t target, const InternedCells& other, std::size_t source, std::size_t n) {
+		if (pool != other.pool && pool->size() == 1) pool = other.pool;
+		if (pool == other.pool) {
+			std::copy_n(other.handles.begin() + static_cast<std::ptrdiff_t>(source), n, handles.begin() + static_cast<std::ptrdiff_t>(target));
+		}
+		else {
+			for (std::size_t i = 0; i < n; ++i) handles[target + i] = pool->Intern(other[source + i]);
+		}
+	}
+
+	// The first cell in [from, to) holding text, or to.
+	std::size_t Next(std::size_t from, std::size_t to, const S& text) const {
+		std::optional<std::uint32_t> h = pool->Find(text);
+		if (!h || from >= to) return to;
+		return static_cast<std::size_t>(std::find(handles.begin() + static_cast<std::ptrdiff_t>(from), handles.begin() + static_cast<std::ptrdiff_t>(to), *h) - handles.begin());
+	}
+
+	// The last cell in [from, to) holding text, or to.
+	std::size_t Previous(std::size_t from, std::size_t to, const S& text) const {
+		std::optional<std::uint32_t> h = pool->Find(text);
+		if (!h) return to;
+		for (std::size_t i = to; i > from; ) {
+			if (handles[--i] == *h) return i;
+		}
+		return to;
+	}
+
+	// The cells in [from, to) holding text.
+	std::size_t Count(std::size_t from, std::size_t to, const S& text) const {
+		std::optional<std::uint32_t> h = pool->Find(text);
+		if (!h || from >= to) return 0;
+		return static_cast<std::size_t>(std::count(handles.begin() + static_cast<std::ptrdiff_t>(from), handles.begin() + static_cast<std::ptrdiff_t>(to), *h));
+	}
+
+	// The first and last cells that do not hold text, or size() and 0 when every cell does.
+	std::pair<std::size_t, std::size_t> Occupied(const S& text) const {
+		std::optional<std::uint32_t> h = pool->Find(text);
+		if (!h) return handles.empty() ? std::make_pair(std::size_t(0), std::size_t(0)) : std::make_pair(std::size_t(0), handles.size() - 1);
+		auto other = [&h](std::uint32_t handle) { return handle != *h; };
+		auto first = std::find_if(handles.begin(), handles.end(), other);
+		if (first == handles.end()) return { handles.size(), 0 };
+		auto last = std::find_if(handles.rbegin(), handles.rend(), other);
+		return { static_cast<std::size_t>(first - handles.begin()), static_cast<std::size_t>(handles.rend() - last - 1) };
+	}
+
+private:
+	std::vector<std::uint32_t> handles;
+	std::shared_ptr<StringPool<S>> pool;
+};
+
+// Tapes of strings are interned.
+template <Value V>
+	requires String<V>
+struct MediumHelper<V> {
+	using type = InternedCells<V>;
+};
+
+// The tapes that scan themselves, rather than being scanned as an array of cells.
+template <typename M>
+concept SelfScanning = requires(const M& m, std::size_t i, const typename M::value_type& v) {
+	m.Next(i, i, v);
+	m.Previous(i, i, v);
+	m.Count(i, i, v);
+};
+
 template <Value V>
 using Token = std::variant<Medium<V>, Program<V>>;
 
+// A TokenView is a Token that does not own its text: a view of a word in a loaded program or in another token, or a single symbol.
+// It is made from a Token or a Medium without copying, so the predicates and lookups that only read a token take one rather than a Token by value.
+// Short owned tokens do not allocate either: a Medium of characters keeps up to 15 of them inline.
+template <Char V>
+struct TokenView : std::variant<std::basic_string_view<V>, Program<V>> {
+	using Base = std::variant<std::basic_string_view<V>, Program<V>>;
+	using Base::Base;
+
+	TokenView(const Medium<V>& text) : Base(std::in_place_index<0>, text) {}
+	TokenView(const Token<V>& token) : Base(std::in_place_index<0>) {
+		if (const Program<V>* symbol = std::get_if<Program<V>>(&token)) this->template emplace<1>(*symbol);
+		else this->template emplace<0>(std::get<Medium<V>>(token));
+	}
+
+	// A Token owning a copy of the text.
+	Token<V> Owned() const {
+		if (const Program<V>* symbol = std::get_if<Program<V>>(this)) return *symbol;
+		return Medium<V>(std::get<0>(*this));
+	}
+};
+
+// Hashes a Medium, a Token and a TokenView of the same text alike, so a container keyed by any of them can be searched with a view, copying nothing.
+struct TokenHash {
+	using is_transparent = void;
+
+	std::size_t operator()(std::u8string_view text) const noexcept { return std::hash<std::u8string_view>{}(text); }
+	std::size_t operator()(const Medium<char8_t>& text) const noexcept { return (*this)(std::u8string_view(text)); }
+	std::size_t operator()(const TokenView<char8_t>& token) const noexcept {
+		if (const char8_t* symbol = std::get_if<char8_t>(&token)) return (*this)(std::u8string_view(symbol, 1));
+		return (*this)(std::get<0>(token));
+	}
+	std::size_t operator()(const Token<char8_t>& token) const noexcept { return (*this)(TokenView<char8_t>(token)); }
+};
+
 
 template <Text V>
 std::ostream& operator<<(std::ostream& os, const Token<V>& tok) {
@@ -243,45 +699,397 @@ Token<char8_t> ToLower (Token<char8_t> text){
 }
 
 
-bool str_predicate(int(*predicate)(int), Token<char8_t> token){
-	if (std::holds_alternative<Program<char8_t>>(token)){
-		return predicate(static_cast<unsigned char>(std::get<Program<char8_t>>(token))) ;
+// Whether token is a name: one or more letters, in any script. A name of ASCII letters is one std::isalpha accepts.
+bool str_name(TokenView<char8_t> token) {
+	if (const char8_t* symbol = std::get_if<char8_t>(&token)) return Utf8::IsLetter(*symbol);
+	return Utf8::IsName(std::get<0>(token));
+}
+
+bool str_predicate(int(*predicate)(int), TokenView<char8_t> token){
+	if (const char8_t* symbol = std::get_if<char8_t>(&token)){
+		return predicate(static_cast<unsigned char>(*symbol)) ;
 	}
-	if (std::holds_alternative<Medium<char8_t>>(token)){
-		for (char8_t c : std::get<Medium<char8_t>>(token) ){
-			if (!predicate(static_cast<unsigned char>(c)))
-				return false;
+	for (char8_t c : std::get<0>(token) ){
+		if (!predicate(static_cast<unsigned char>(c)))
+			return false;
+	}
+	return true;
+}
+
+// A value of type T written as a word: true, false, 1 or 0 for bool, one character or its code for a character type,
+// a number read by from_chars for any other arithmetic type, the word itself for a string, and the word given to From or the constructor for a Defined type.
+// Nothing if the whole word is not a T.
+template <Value T>
+std::optional<T> ParseValue(std::u8string_view word) {
+	if (word.empty()) return std::nullopt;
+	if constexpr (std::is_same_v<T, bool>) {
+		auto is = [word](std::u8string_view name) {
+			return std::ranges::equal(word, name, [](char8_t a, char8_t b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+		};
+		if (is(u8"true") || is(u8"1")) return true;
+		if (is(u8"false") || is(u8"0")) return false;
+		return std::nullopt;
+	}
+	else if constexpr (String<T>) {
+		return T(word.begin(), word.end());
+	}
+	else if constexpr (Char<T>) {
+		if (word.size() == 1) return static_cast<T>(word[0]);
+		long long code = 0;
+		const char* first = reinterpret_cast<const char*>(word.data());
+		auto [ptr, ec] = std::from_chars(first, first + word.size(), code);
+		if (ec != std::errc{} || ptr != first + word.size()) return std::nullopt;
+		return static_cast<T>(code);
+	}
+	else if constexpr (Arithmetic<T>) {
+		T value{};
+		const char* first = reinterpret_cast<const char*>(word.data());
+		auto [ptr, ec] = std::from_chars(first, first + word.size(), value);
+		if (ec != std::errc{} || ptr != first + word.size()) return std::nullopt;
+		return value;
+	}
+	else if constexpr (requires(const std::u8string& text) { { T::From(text) } -> std::same_as<std::optional<T>>; }) {
+		return T::From(std::u8string(word));
+	}
+	else {
+		try {
+			return T(std::u8string(word));
+		}
+		catch (...) {
+			return std::nullopt;
 		}
-		return true;
 	}
-	return false;
 }
 
-std::set<char8_t> GetCharacterSet(int (*predicate)(int)) {
-    std::set<char8_t> result;
-    for (int i = 0; i <= UCHAR_MAX; ++i) {
-        if (predicate(static_cast<unsigned char>(i))) {
-            result.insert(static_cast<char8_t>(i));
-        }
-    }
-    return result;
+// A CharClass is a set of bytes kept as 256 bits in four words, so membership is a shift and a mask,
+// and union, intersection, difference and inclusion are four word operations, which the compiler does in vector registers.
+// It is the alphabet of a Language over char8_t, and iterates in increasing order like the std::set it replaces.
+class CharClass {
+public:
+	using value_type = char8_t;
+	using Words = std::array<std::uint64_t, 4>;
+
+	class const_iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = char8_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const char8_t*;
+		using reference = char8_t;
+
+		constexpr const_iterator() = default;
+		constexpr const_iterator(const CharClass* c, unsigned p) : cls(c), pos(p) { Settle(); }
+
+		constexpr char8_t operator*() const { return static_cast<char8_t>(pos); }
+		constexpr const_iterator& operator++() {
+			++pos;
+			Settle();
+			return *this;
+		}
+		constexpr const_iterator operator++(int) {
+			const_iterator before = *this;
+			++*this;
+			return before;
+		}
+		constexpr bool operator==(const const_iterator& other) const { return pos == other.pos; }
+
+	private:
+		const CharClass* cls = nullptr;
+		unsigned pos = 256;
+
+		// Moves pos to the first member at or after it, a word at a time.
+		constexpr void Settle() {
+			while (pos < 256) {
+				std::uint64_t rest = cls->bits[pos >> 6] >> (pos & 63);
+				if (rest != 0) {
+					pos += static_cast<unsigned>(std::countr_zero(rest));
+					return;
+				}
+				pos = (pos | 63) + 1;
+			}
+		}
+	};
+	using iterator = const_iterator;
+
+	constexpr CharClass() = default;
+	constexpr explicit CharClass(const Words& words) : bits(words) {}
+	constexpr CharClass(std::initializer_list<char8_t> chars) {
+		for (char8_t c : chars) insert(c);
+	}
+
+	// The bytes predicate holds for. It is constexpr for a constexpr predicate, so a class can be built at compile time.
+	template <typename Predicate>
+		requires std::predicate<Predicate, int>
+	static constexpr CharClass Of(Predicate predicate) {
+		CharClass result;
+		for (unsigned c = 0; c <= UCHAR_MAX; ++c) {
+			if (predicate(static_cast<int>(c))) result.bits[c >> 6] |= std::uint64_t(1) << (c & 63);
+		}
+		return result;
+	}
+
+	// The bytes first to last, both included.
+	static constexpr CharClass Range(char8_t first, char8_t last) {
+		return Of([first, last](int c) { return c >= first && c <= last; });
+	}
+
+	constexpr bool contains(char8_t c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+
+	constexpr std::pair<const_iterator, bool> insert(char8_t c) {
+		bool added = !contains(c);
+		bits[c >> 6] |= std::uint64_t(1) << (c & 63);
+		return { const_iterator(this, c), added };
+	}
+
+	constexpr std::size_t erase(char8_t c) {
+		bool had = contains(c);
+		bits[c >> 6] &= ~(std::uint64_t(1) << (c & 63));
+		return had;
+	}
+
+	constexpr std::size_t size() const {
+		std::size_t n = 0;
+		for (std::uint64_t w : bits) n += static_cast<std::size_t>(std::popcount(w));
+		return n;
+	}
+
+	constexpr bool empty() const { return (bits[0] | bits[1] | bits[2] | bits[3]) == 0; }
+
+	constexpr const_iterator begin() const { return const_iterator(this, 0); }
+	constexpr const_iterator end() const { return const_iterator(this, 256); }
+
+	// Whether every byte of text is a member.
+	constexpr bool Spans(std::u8string_view text) const {
+		for (char8_t c : text) {
+			if (!contains(c)) return false;
+		}
+		return true;
+	}
+
+	// Whether every member of other is a member of this one.
+	constexpr bool Includes(const CharClass& other) const { return (other - *this).empty(); }
+
+	constexpr CharClass& operator|=(const CharClass& other) {
+		for (std::size_t i = 0; i < 4; ++i) bits[i] |= other.bits[i];
+		return *this;
+	}
+	constexpr CharClass& operator&=(const CharClass& other) {
+		for (std::size_t i = 0; i < 4; ++i) bits[i] &= other.bits[i];
+		return *this;
+	}
+	constexpr CharClass& operator-=(const CharClass& other) {
+		for (std::size_t i = 0; i < 4; ++i) bits[i] &= ~other.bits[i];
+		return *this;
+	}
+
+	friend constexpr CharClass operator|(CharClass a, const CharClass& b) { return a |= b; }
+	friend constexpr CharClass operator&(CharClass a, const CharClass& b) { return a &= b; }
+	friend constexpr CharClass operator-(CharClass a, const CharClass& b) { return a -= b; }
+	friend constexpr CharClass operator~(CharClass a) {
+		for (std::uint64_t& w : a.bits) w = ~w;
+		return a;
+	}
+
+	constexpr bool operator==(const CharClass&) const = default;
+
+	const Words& Bits() const { return bits; }
+
+private:
+	Words bits{};
+};
+
+// Set operations on character classes, kept under the names the std::set versions had.
+constexpr CharClass Intersection(const CharClass& a, const CharClass& b) { return a & b; }
+constexpr CharClass Union(const CharClass& a, const CharClass& b) { return a | b; }
+constexpr CharClass Difference(const CharClass& a, const CharClass& b) { return a - b; }
+// Whether b is a subset of a, as std::includes(a, b).
+constexpr bool Inclusion(const CharClass& a, const CharClass& b) { return a.Includes(b); }
+
+// The bytes predicate holds for. The ctype predicates are not constexpr, so this runs at registration, once per class.
+CharClass GetCharacterSet(int (*predicate)(int)) {
+	return CharClass::Of([predicate](int c) { return predicate(c) != 0; });
 }
 
+// Building with LANGUAGE_PROFILE defined to 1 makes every Language count and time the Syntax and Semantic calls of its concepts.
+// Left at 0, the profiling hooks are discarded at compile time and cost nothing.
+#ifndef LANGUAGE_PROFILE
+#define LANGUAGE_PROFILE 0
+#endif
+
+constexpr bool Profiling = LANGUAGE_PROFILE != 0;
+
+// What the profiler has seen of one concept. Times are in nanoseconds.
+struct ConceptProfile {
+	unsigned long long tried = 0; // calls to its Syntax
+	unsigned long long matched = 0; // calls to its Syntax that recognized the token
+	unsigned long long syntaxtime = 0;
+	unsigned long long evaluated = 0; // calls to its Semantic
+	unsigned long long semantictime = 0;
+	unsigned long long before = 0; // rules tried ahead of it, summed over its matches
+
+	ConceptProfile& operator+=(const ConceptProfile& other) {
+		tried += other.tried;
+		matched += other.matched;
+		syntaxtime += other.syntaxtime;
+		evaluated += other.evaluated;
+		semantictime += other.semantictime;
+		before += other.before;
+		return *this;
+	}
+};
+
+// Why a token was not recognized. A Malformed token is one a syntax claimed but could not take, such as a write without a value.
+enum class Unrecognized { NotAWord, Unknown, Malformed };
+
 // The Language struct represents a formal language defined by an alphabet and a set of interpretations (concepts). It provides methods to add symbols, check if a program is well-formed, and evaluate programs based on the defined syntax and semantics.
 template <Value V>
 class Language {
-	using Alphabet = std::set<Program<V>>;
+	public:
+	// A language over bytes keeps its alphabet as a CharClass; any other keeps a set of its symbols.
+	using Alphabet = std::conditional_t<std::is_same_v<V, char8_t>, CharClass, std::set<Program<V>>>;
+
+	// What a syntax makes of a token: how many characters of it the concept takes, zero if the syntax does not match,
+	// and the operands it parsed on the way. Evaluate hands the operands to the semantic, so an instruction is parsed once;
+	// a syntax that leaves them empty, or a semantic run without recognizing its token first, parses the token itself.
+	struct Reading {
+		unsigned long long consumed = 0;
+		std::any operands;
+
+		Reading(unsigned long long consumed = 0) : consumed(consumed) {}
+		Reading(unsigned long long consumed, std::any operands) : consumed(consumed), operands(std::move(operands)) {}
+
+		operator unsigned long long() const { return consumed; }
+	};
 
-	// Syntax returns unsigned long long. If zero, the syntax does not match. If non-zero, it indicates how many characters of the program were consumed by the syntax rule.
-	using Syntax = std::function<unsigned long long(const Token<V>&)>;
-	using Semantic = std::function<std::any (const Token<V>&)>;
+	// A syntax returning a plain length converts to a Reading without operands.
+	using Syntax = std::function<Reading(const Token<V>&)>;
+	using Semantic = std::function<std::any (const Token<V>&, const std::any&)>;
 	//using Semantic = std::function<Value auto (const Medium<V>&)>;
 	using Concept = std::tuple<Token<V>, Syntax, Semantic>;
 	using Interpretation = std::vector<Concept>;
+	using Match = std::pair<const Concept*, Reading>;
+
+	// A syntax that claims a token it cannot take returns Rejected rather than throwing. It ends the search like a match,
+	// and has_interpretation throws for it, so only the public entry points pay for an exception.
+	static constexpr unsigned long long Rejected = ULLONG_MAX;
 
-	public:
 	Alphabet A;
 	Interpretation I;
+	std::set<Token<V>> Literals; // names of the character class interpretations
+
+	// The command words of the concepts registered with a set of them, each to the position in I of the concept it names.
+	// A concept registered later takes a word over, since it would be tried first.
+	std::unordered_map<Medium<V>, std::size_t> Commands;
+
+	// The Profiler keeps one block of counters per thread, indexed like I, so the hooks never share a cache line or take a lock.
+	// Report merges the blocks of every thread. Call it while no thread is evaluating in the language.
+	class Profiler {
+	public:
+		enum class Rank { Time, Hits, Tried };
+
+		struct Entry {
+			Token<V> name;
+			std::size_t index; // position in I
+			ConceptProfile profile;
+		};
+
+		struct Block {
+			std::vector<ConceptProfile> concepts;
+			unsigned long long lookups = 0; // calls to has_interpretation
+			unsigned long long misses = 0; // lookups no concept recognized
+		};
+
+		Profiler() : id(++Ids) {}
+		Profiler(const Profiler&) : id(++Ids) {}
+		Profiler& operator=(const Profiler&) { return *this; }
+
+		// The block of the calling thread, made on its first use.
+		Block& Local() {
+			thread_local std::unordered_map<unsigned long long, Block*> blocks;
+			thread_local unsigned long long lastid = 0;
+			thread_local Block* last = nullptr;
+			if (lastid == id) return *last;
+
+			Block*& block = blocks[id];
+			if (block == nullptr) {
+				std::lock_guard<std::mutex> lock(mutex);
+				threads.push_back(std::make_unique<Block>());
+				block = threads.back().get();
+			}
+			lastid = id;
+			last = block;
+			return *block;
+		}
+
+		ConceptProfile& At(std::size_t index) {
+			Block& block = Local();
+			if (index >= block.concepts.size()) block.concepts.resize(index + 1);
+			return block.concepts[index];
+		}
+
+		// Every concept of the language that was tried, ranked from the most expensive down.
+		std::vector<Entry> Report(const Interpretation& I, Rank rank = Rank::Time) {
+			std::vector<Entry> entries;
+			for (std::size_t i = 0; i < I.size(); ++i) entries.push_back(Entry{ std::get<0>(I[i]), i, {} });
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const auto& block : threads) {
+				for (std::size_t i = 0; i < block->concepts.size() && i < entries.size(); ++i) entries[i].profile += block->concepts[i];
+			}
+			std::erase_if(entries, [](const Entry& e) { return e.profile.tried == 0 && e.profile.evaluated == 0; });
+			auto key = [rank](const Entry& e) {
+				switch (rank) {
+				case Rank::Hits: return e.profile.matched;
+				case Rank::Tried: return e.profile.tried;
+				default: return e.profile.syntaxtime + e.profile.semantictime;
+				}
+			};
+			std::stable_sort(entries.begin(), entries.end(), [&key](const Entry& a, const Entry& b) { return key(a) > key(b); });
+			return entries;
+		}
+
+		unsigned long long Lookups() {
+			std::lock_guard<std::mutex> lock(mutex);
+			unsigned long long n = 0;
+			for (const auto& block : threads) n += block->lookups;
+			return n;
+		}
+
+		unsigned long long Misses() {
+			std::lock_guard<std::mutex> lock(mutex);
+			unsigned long long n = 0;
+			for (const auto& block : threads) n += block->misses;
+			return n;
+		}
+
+		void Clear() {
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const auto& block : threads) *block = Block{};
+		}
+
+	private:
+		static inline std::atomic<unsigned long long> Ids = 0; // never reused, so a thread can not find the block of a dead profiler
+		unsigned long long id;
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Block>> threads;
+	};
+
+	Profiler profiler;
+
+	static unsigned long long Since(std::chrono::steady_clock::time_point begin) {
+		return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+	}
+
+	// A table of the profiled concepts, most expensive first: the rules to reorder, specialize or cache.
+	void WriteProfile(std::ostream& os, typename Profiler::Rank rank = Profiler::Rank::Time) {
+		auto entries = profiler.Report(I, rank);
+		os << "lookups " << profiler.Lookups() << ", misses " << profiler.Misses() << "\n";
+		os << "concept\ttried\tmatched\tsyntax ns\tevaluated\tsemantic ns\tbefore/match\n";
+		for (const auto& e : entries) {
+			const ConceptProfile& p = e.profile;
+			os << e.name << '\t' << p.tried << '\t' << p.matched << '\t' << p.syntaxtime << '\t' << p.evaluated << '\t' << p.semantictime << '\t'
+				<< (p.matched ? static_cast<double>(p.before) / static_cast<double>(p.matched) : 0.0) << '\n';
+		}
+	}
 
 	Language() {
 
@@ -309,6 +1117,8 @@ class Language {
 
 	}
 
+	// A literal for every primitive type, for a language of typed values.
+	// The machine language does without them, as its commands read their own operands.
 	void AddTypeInterpretations() {
 		InterpretType<bool>();
 		InterpretType<char>();
@@ -317,6 +1127,7 @@ class Language {
 		InterpretType<char8_t>();
 		InterpretType<char16_t>();
 		InterpretType<char32_t>();
+		InterpretType<wchar_t>();
 
 		InterpretType<short>();
 		InterpretType<unsigned short>();
@@ -332,82 +1143,72 @@ class Language {
 		InterpretType<long double>();
 	}
 
-	// Helper function to extract the first token from a program, returning it and modifying the original program to remove the extracted token
-	Medium<V> Munch(Medium<V>& prog) {
-		Medium<V> program{};
-		size_t i = 0;
-		while (i < prog.size() && std::isspace(static_cast<unsigned char>(prog[i]))) {
-			++i;
-		}
+	// The length of the whitespace character at i of prog, or 0 if none starts there.
+	// Over char8_t that is any Unicode White_Space character, so words also split at a no-break or an ideographic space.
+	static std::size_t Space(const Medium<V>& prog, std::size_t i) {
+		if constexpr (std::is_same_v<V, char8_t>) return Utf8::SpaceAt(prog, i);
+		else return std::isspace(static_cast<unsigned char>(prog[i])) ? 1 : 0;
+	}
 
-		while (i < prog.size() && !std::isspace(static_cast<unsigned char>(prog[i]))) {
-			program += prog[i];
-			++i;
+	// Where the whitespace from i of prog on ends.
+	static std::size_t SkipSpace(const Medium<V>& prog, std::size_t i) {
+		while (i < prog.size()) {
+			std::size_t width = Space(prog, i);
+			if (width == 0) break;
+			i += width;
 		}
+		return i;
+	}
 
-		while (i < prog.size() && std::isspace(static_cast<unsigned char>(prog[i]))) {
-			++i;
-		}
-		prog.erase(0, i);
+	// Where the word from i of prog on ends. A continuation byte never starts a space, so a word is scanned a byte at a time.
+	static std::size_t SkipWord(const Medium<V>& prog, std::size_t i) {
+		while (i < prog.size() && Space(prog, i) == 0) ++i;
+		return i;
+	}
+
+	// Helper function to extract the first token from a program, returning it and modifying the original program to remove the extracted token
+	Medium<V> Munch(Medium<V>& prog) {
+		std::size_t begin = SkipSpace(prog, 0);
+		std::size_t end = SkipWord(prog, begin);
+		Medium<V> program(prog.begin() + begin, prog.begin() + end);
+		prog.erase(0, SkipSpace(prog, end));
 		return program;
 	}
 
 	// A proper Munch.
 	std::pair<Medium<V>, unsigned long long> Lunch(const Medium<V>& prog) {
-		Medium<V> program{};
-		size_t i = 0;
-		while (i < prog.size() && std::isspace(static_cast<unsigned char>(prog[i]))) {
-			++i;
-		}
-
-		while (i < prog.size() && !std::isspace(static_cast<unsigned char>(prog[i]))) {
-			program += prog[i];
-			++i;
-		}
-
-		while (i < prog.size() && std::isspace(static_cast<unsigned char>(prog[i]))) {
-			++i;
-		}
-		return std::make_pair(program, i);
+		std::size_t begin = SkipSpace(prog, 0);
+		std::size_t end = SkipWord(prog, begin);
+		return std::make_pair(Medium<V>(prog.begin() + begin, prog.begin() + end), SkipSpace(prog, end));
 	}
 
 	// This function extracts the first bite of a program.
 	Program<V> Nibble (Medium<V> & prog){
 		Program<V> bite;
-		size_t i = 0;
-		while (i < prog.size() && std::isspace(static_cast<unsigned char>(prog[i]))) {
-			++i;
-		}
+		size_t i = SkipSpace(prog, 0);
 		bite = prog[i];
-		while (i < prog.size() && std::isspace(static_cast<unsigned char>(prog[i]))) {
-			++i;
-		}
 		prog.erase(0, i);
 		return bite; 
 	}
 
 	// This function copies the first chunk of a program.
 	Medium<V> Lick (const Medium<V>& prog){
-		Medium<V> program{};
-		size_t i = 0;
-		while (i < prog.size() && std::isspace(static_cast<unsigned char>(prog[i]))) {
-			++i;
-		}
+		std::size_t begin = SkipSpace(prog, 0);
+		return Medium<V>(prog.begin() + begin, prog.begin() + SkipWord(prog, begin));
+	}
 
-		while (i < prog.size() && !std::isspace(static_cast<unsigned char>(prog[i]))) {
-			program += prog[i];
-			++i;
-		}
-		return program;
+	// This function copies the word at pos and moves pos past it and the whitespace around it, leaving the program alone.
+	// Reading the words of an instruction one Bite at a time does not copy the rest of it each time, as Munch does.
+	Medium<V> Bite(const Medium<V>& prog, std::size_t& pos) {
+		std::size_t begin = SkipSpace(prog, pos);
+		std::size_t end = SkipWord(prog, begin);
+		pos = SkipSpace(prog, end);
+		return Medium<V>(prog.begin() + begin, prog.begin() + end);
 	}
 
 	// This function copies the first bite of a program.
 	Program<V> Lick_V (const Medium<V> & prog){
-		size_t i = 0;
-		while (i < prog.size() && std::isspace(static_cast<unsigned char>(prog[i]))) {
-			++i;
-		}
-		return prog[i]; 
+		return prog[SkipSpace(prog, 0)]; 
 	}
 
 	// Helper function to split a program into tokens based on whitespace, using Munch to extract tokens iteratively
@@ -436,7 +1237,7 @@ class Language {
 		bool ret = true;
 		if (std::holds_alternative<Medium<V>>(token)){
 			for (const Program<V>& symbol : std::get<Medium<V>>(token)) {
-				ret = ret && A.insert(symbol).second;
+				ret = A.insert(symbol).second && ret;
 			}
 			return ret;
 		}
@@ -444,11 +1245,18 @@ class Language {
 	}
 
 	bool AddSymbols (const Alphabet& a){
-		bool ret = true;
-		for (Program<V> symbol: a){
-			ret = ret && A.insert(symbol).second;
+		if constexpr (std::is_same_v<Alphabet, CharClass>) {
+			bool ret = (A & a).empty();
+			A |= a;
+			return ret;
+		}
+		else {
+			bool ret = true;
+			for (Program<V> symbol: a){
+				ret = A.insert(symbol).second && ret;
+			}
+			return ret;
 		}
-		return ret;
 	}
 
 
@@ -471,23 +1279,98 @@ class Language {
 		return false;
 	}
 
+	// The concept that takes text and how much of it. Throws for text with symbols outside the alphabet and for an instruction a syntax claimed but could not take.
 	std::pair<const Concept*, unsigned long long> is_well_formed(const Token<V>& text) {
-		//return is_word(text) && has_interpretation(text) ;
-		if (is_word(text)) {
-			return has_interpretation(text);
-		}
-		throw std::invalid_argument("text is not well-formed: contains symbols not in the alphabet\n");
-		return { nullptr, 0 };
+		if (!is_word(text)) throw std::invalid_argument("text is not well-formed: contains symbols not in the alphabet\n");
+		std::expected<Match, Unrecognized> found = Lookup(text);
+		if (!found && found.error() == Unrecognized::Malformed) throw std::invalid_argument("Malformed instruction\n");
+		if (!found) return { nullptr, 0 };
+		return *found;
 	}
-	
-	// This function returns true if its syntax is recognized from within the Concepts
 
+	// Interpretations registered later are more specialized, so they are tried first.
+	// A token no concept takes, or one a syntax rejects, has none.
 	std::pair<const Concept*, unsigned long long> has_interpretation(const Token<V>& token) {
-		for (const Concept& c : I) {
-			unsigned long long consumed = std::get<1>(c)(token);
-			if (consumed > 0) return {&c, consumed};
+		std::expected<Match, Unrecognized> found = Lookup(token);
+		if (!found) return { nullptr, 0 };
+		return *found;
+	}
+
+	// is_well_formed without the exceptions, for the decoders, which try most tokens against languages that do not recognize them.
+	// The syntaxes report a token they do not take by their return value, so nothing is thrown unless a syntax of the caller's throws.
+	std::expected<Match, Unrecognized> Recognize(const Token<V>& token) {
+		if (!is_word(token)) return std::unexpected(Unrecognized::NotAWord);
+		return Lookup(token);
+	}
+
+	// How much of token the concept at position rule of I takes, without trying the others.
+	std::expected<Reading, Unrecognized> Recognize(std::size_t rule, const Token<V>& token) const {
+		Reading consumed = std::get<1>(I[rule])(token);
+		if (consumed == Rejected) return std::unexpected(Unrecognized::Malformed);
+		if (consumed == 0) return std::unexpected(Unrecognized::Unknown);
+		return consumed;
+	}
+
+	// The concept that takes token and how much of it. Unknown if none does, and Malformed for a token a syntax claimed and could not take,
+	// which ends the search like a match.
+	std::expected<Match, Unrecognized> Lookup(const Token<V>& token) {
+		if constexpr (Profiling) return ProfiledInterpretation(token);
+		for (auto c = I.rbegin(); c != I.rend(); ++c) {
+			Reading consumed = std::get<1>(*c)(token);
+			if (consumed == Rejected) return std::unexpected(Unrecognized::Malformed);
+			if (consumed > 0) return Match{ &*c, std::move(consumed) };
+		}
+		return std::unexpected(Unrecognized::Unknown);
+	}
+
+	std::expected<Match, Unrecognized> ProfiledInterpretation(const Token<V>& token) {
+		++profiler.Local().lookups;
+		unsigned long long tried = 0;
+		for (auto c = I.rbegin(); c != I.rend(); ++c, ++tried) {
+			auto begin = std::chrono::steady_clock::now();
+			Reading consumed = std::get<1>(*c)(token);
+			// looked up after the call, which may have profiled other lookups and grown the block
+			ConceptProfile& p = profiler.At(static_cast<std::size_t>(&*c - I.data()));
+			p.syntaxtime += Since(begin);
+			++p.tried;
+			if (consumed == Rejected) return std::unexpected(Unrecognized::Malformed);
+			if (consumed > 0) {
+				++p.matched;
+				p.before += tried;
+				return Match{ &*c, std::move(consumed) };
+			}
+		}
+		++profiler.Local().misses;
+		return std::unexpected(Unrecognized::Unknown);
+	}
+
+	// A literal is a token recognized only by a character class, such as a digit string. Literals have the least precedence.
+	bool is_literal(const Concept& c) const {
+		return Literals.contains(std::get<0>(c));
+	}
+
+	// Records comms as the command words of the concept named t, if there is one.
+	void Alias(const Token<V>& t, const std::set<Medium<V>>& comms) {
+		for (std::size_t i = I.size(); i-- > 0;) {
+			if (std::get<0>(I[i]) != t) continue;
+			for (const Medium<V>& c : comms) Commands[c] = i;
+			return;
 		}
-		return { nullptr, 0 };
+	}
+
+	// The first word of prog in lower case, as the command syntaxes compare it with their command words.
+	static Medium<V> CommandWord(const Medium<V>& prog) {
+		std::size_t begin = SkipSpace(prog, 0);
+		Medium<V> word(prog.begin() + begin, prog.begin() + SkipWord(prog, begin));
+		for (V& c : word) c = static_cast<V>(std::tolower(static_cast<unsigned char>(c)));
+		return word;
+	}
+
+	// The position in I of the concept whose command word starts prog, if any.
+	std::optional<std::size_t> Command(const Medium<V>& prog) const {
+		auto found = Commands.find(CommandWord(prog));
+		if (found == Commands.end()) return std::nullopt;
+		return found->second;
 	}
 
 	bool is_registered(const Token<V>& token) {
@@ -497,8 +1380,10 @@ class Language {
 		return false;
 	}
 	
-	// Base Interpret method for custom syntax and semantics of strings
-	bool Interpret(const Alphabet& a, const Token<V>& t, Syntax syn, Semantic sem) {
+	// Base Interpret method for custom syntax and semantics of strings.
+	// The semantic takes the token and the operands its syntax parsed, or only the token if it parses the token itself.
+	template <typename F>
+	bool Interpret(const Alphabet& a, const Token<V>& t, Syntax syn, F sem) {
 		for (const Concept& c : I) {
 			if (std::get<0>(c) == t) {
 				throw std::invalid_argument("token already taken\n");
@@ -508,7 +1393,8 @@ class Language {
 		AddSymbols(t);
 		AddSymbols(a);
 		if (is_word(t)) {
-			I.push_back(std::make_tuple(t,syn,sem));
+			if constexpr (std::is_invocable_r_v<std::any, F&, const Token<V>&, const std::any&>) I.push_back(std::make_tuple(t, std::move(syn), Semantic(std::move(sem))));
+			else I.push_back(std::make_tuple(t, std::move(syn), Semantic([f = std::move(sem)](const Token<V>& prog, const std::any&) -> std::any { return f(prog); })));
 			return true;
 		}
 		return false;
@@ -517,110 +1403,125 @@ class Language {
 	// Interpret method overload for Value-returning functions with no arguments.
 	bool Interpret(const Token<V>& t, std::function <std::any ()> f) {
 		return Interpret(
-			std::set<Program<V>>{},
+			Alphabet{},
 			t,
 			[this, t](const Token<V>& prog) { return this->NameSyntax(t, prog); },
-			[this, f](const Token<V>& prog) {return this->NullarySemantic(f); });
+			[this, f](const Token<V>&) {return this->NullarySemantic(f); });
 	}
 	bool InterpretNullaryFunction(const Token<V>& t, const std::set<Medium<V>>& comms, std::function<std::any ()> f) {
-		return Interpret(
-			std::set<Program<V>>{},
+		bool added = Interpret(
+			Alphabet{},
 			t,
 			[this, comms](const Token<V>& prog) { return this->MediumFunctionSyntax(prog, comms); },
-			[this, f](const Token<V>& prog) { return this->NullarySemantic(f); }
+			[this, f](const Token<V>&) { return this->NullarySemantic(f); }
 		);
+		if (added) Alias(t, comms);
+		return added;
 	}
 	void InterpretNullaryVoidFunction(const Token<V>& t, const std::set<Medium<V>>& comms, std::function<void()> f) {
-		Interpret(
-			std::set<Program<V>>{},
+		if (Interpret(
+			Alphabet{},
 			t,
 			[this, comms](const Token<V>& prog) { return this->MediumFunctionSyntax(prog, comms); },
-			[this, f](const Token<V>& prog) { this->VoidSemantic(f); return std::any{}; }
-		);
+			[this, f](const Token<V>&) { this->VoidSemantic(f); return std::any{}; }
+		)) Alias(t, comms);
 	}
 
 	// Interpret method overload for Value types.
 	bool Interpret(const Token<V>& t, std::any a) {
 		return Interpret(
-			std::set<Program<V>>{},
+			Alphabet{},
 			t,
 			[this, t](const Token<V>& prog) { return this->NameSyntax(t, prog); },
-			[this, a](const Token<V>& prog) {return this->IdentitySemantic(a); }
+			[this, a](const Token<V>&) {return this->IdentitySemantic(a); }
 		);
 	}
 
-		// Helper function to interpret a type T by adding its name to the alphabet and defining its interpretation
-	// template<typename T>
-	// void InterpretType() {
-	// 	const std::u8string type_name = typeid(T).name();
-	// 	if (!is_well_formed(type_name)) {
-	// 		T epsilon {};
-	// 		Interpret(type_name, epsilon);
-
-	// 	}
-	// }
-
-	// Helper function to interpret a type T by adding its name to the alphabet 
-	// and defining its interpretation safely across different character types V.
-	template<typename T>
-	bool InterpretType() {
-		const char* raw_name = typeid(T).name();
-		std::string narrow_name(raw_name);
-
-		Token<V> type_token;
-		if constexpr (String<Program<V>>) {
-			type_token = Program<V>(narrow_name);
-		} else if constexpr (Char<Program<V>>) {
-			return false;	
+	// The name a type is registered under by InterpretType: its C++ name, with an underscore for a space, or the mangled name for a type of its own.
+	template <Value T>
+	static Medium<char8_t> TypeName() {
+		if constexpr (std::is_same_v<T, bool>) return u8"bool";
+		else if constexpr (std::is_same_v<T, char>) return u8"char";
+		else if constexpr (std::is_same_v<T, signed char>) return u8"signed_char";
+		else if constexpr (std::is_same_v<T, unsigned char>) return u8"unsigned_char";
+		else if constexpr (std::is_same_v<T, char8_t>) return u8"char8_t";
+		else if constexpr (std::is_same_v<T, char16_t>) return u8"char16_t";
+		else if constexpr (std::is_same_v<T, char32_t>) return u8"char32_t";
+		else if constexpr (std::is_same_v<T, wchar_t>) return u8"wchar_t";
+		else if constexpr (std::is_same_v<T, short>) return u8"short";
+		else if constexpr (std::is_same_v<T, unsigned short>) return u8"unsigned_short";
+		else if constexpr (std::is_same_v<T, int>) return u8"int";
+		else if constexpr (std::is_same_v<T, unsigned int>) return u8"unsigned_int";
+		else if constexpr (std::is_same_v<T, long>) return u8"long";
+		else if constexpr (std::is_same_v<T, unsigned long>) return u8"unsigned_long";
+		else if constexpr (std::is_same_v<T, long long>) return u8"long_long";
+		else if constexpr (std::is_same_v<T, unsigned long long>) return u8"unsigned_long_long";
+		else if constexpr (std::is_same_v<T, float>) return u8"float";
+		else if constexpr (std::is_same_v<T, double>) return u8"double";
+		else if constexpr (std::is_same_v<T, long double>) return u8"long_double";
+		else {
+			const std::string name = typeid(T).name();
+			return Medium<char8_t>(name.begin(), name.end());
 		}
+	}
 
-		if (has_interpretation(type_token).first != nullptr) {
-			T epsilon {};
-			return Interpret(type_token, epsilon);
+	// A literal for the values of T: a word ParseValue reads as a T, which evaluates to that T.
+	// False if the language is not over char8_t or T already has a literal.
+	template <Value T>
+	bool InterpretType() {
+		if constexpr (!std::is_same_v<V, char8_t>) return false;
+		else {
+			const Token<V> name = TypeName<T>();
+			if (is_registered(name)) return false;
+			if (!Interpret(
+				Alphabet{},
+				name,
+				[](const Token<V>& prog) -> Reading {
+					if (!std::holds_alternative<Medium<V>>(prog)) return 0;
+					const Medium<V>& word = std::get<Medium<V>>(prog);
+					std::optional<T> value = ParseValue<T>(word);
+					if (!value) return 0;
+					return { word.size(), std::move(*value) };
+				},
+				[](const Token<V>& prog, const std::any& value) -> std::any {
+					if (value.has_value()) return value;
+					return *ParseValue<T>(std::get<Medium<V>>(prog));
+				}
+			)) return false;
+			Literals.insert(name);
+			return true;
 		}
-		return false;
 	}
 
-	// void InterpretType() {
-	// 	// 1. Use C++26 reflection to get the type's name at compile-time
-	// 	// std::meta::name_of returns a string_view of the type's identifier
-	// 	constexpr auto type_name_view = std::meta::name_of(^T);
-		
-	// 	// 2. Convert to your language's specific Program<V> type
-	// 	Token<V> type_token;
-		
-	// 	if constexpr (String<Program<V>>) {
-	// 		// Safe conversion from string_view to u8string/string/etc.
-	// 		type_token = Program<V>(type_name_view.begin(), type_name_view.end());
-	// 	} 
-	// 	else if constexpr (Char<Program<V>>) {
-	// 		// Fallback for single-char tokens
-	// 		type_token = static_cast<Program<V>>(type_name_view[0]);
-	// 	}
-
-	// 	// 3. Register with the Abstract Machine's alphabet
-	// 	if (!has_interpretation(type_token)) {
-	// 		T epsilon {};
-	// 		Interpret(type_token, std::any(epsilon));
-	// 	}
-	// }
-
+	// A character class: the tokens made only of the bytes predicate holds for.
+	// The syntax tests the class, which is a bit per byte, rather than calling predicate for every character.
 	void InterpretPredicate(int(*predicate)(int), const Token<V>& name) {
+		const CharClass cls = GetCharacterSet(predicate);
 		Interpret(
-			GetCharacterSet(predicate), 
+			cls,
 			name, 
-			[predicate](const Token<V>& prog) { return str_predicate(predicate, prog); },
+			[cls](const Token<V>& prog) {
+				if (std::holds_alternative<Program<V>>(prog)) return cls.contains(std::get<Program<V>>(prog)) ? 1ULL : 0ULL;
+				const Medium<V>& text = std::get<Medium<V>>(prog);
+				return cls.Spans(text) ? static_cast<unsigned long long>(text.size()) : 0ULL;
+			},
 			[this](const Token<V>& prog) { return this->IdentitySemantic(prog); }
 		);
+		Literals.insert(name);
+	}
+
+	static unsigned long long Length(const Token<V>& token) {
+		if (std::holds_alternative<Program<V>>(token)) return 1;
+		return std::get<Medium<V>>(token).size();
 	}
 
 	void InterpretMediumFunction(const Token<V>& name, const std::set<Medium<V>>& comms, std::function<std::any(const Medium<V>&)> f) {
-		 Interpret(
-			std::set<Program<V>>{}, 
+		if (Interpret(
+			Alphabet{},
 			name, 
 			[this, comms](const Token<V>& prog) { return this->MediumFunctionSyntax(prog, comms); },
 			[this, f](const Token<V>& prog) { return this->MediumFunctionSemantic(prog, f); }
-		);
+		)) Alias(name, comms);
 	}
 
 	// void InterpretVoidFunction(const Token<V>& t, const std::set<Medium<V>>& comms, std::function<void(const Medium<V>&)> f) {
@@ -631,45 +1532,74 @@ class Language {
 	// 		[this, f](const Token<V>& prog) { this->MediumFunctionSemantic(std::get<Medium<V>>(prog), f); }
 	// 	);
 	// }
-	// FunctionName: Args... -> Ret = { } 
-	// Helper function to interpret a function with a specific syntax and semantics based on its return type and argument types
-	template <Value Ret, Value...Args>
-	bool InterpretFunction(const Token<V>& name, const Token<V>& prog, std::function<Ret(Args...)>) {
-		size_t Arguments = sizeof...(Args);
-		using ArgumentTypes = std::tuple<Args...>;
-
-		// Interpret each argument type
-		(InterpretType<Args>(), ...);
-		// Interpret return type
-		InterpretType<Ret>();
-
-		ProgramFile<char8_t> Program = Chunkify(prog);
-
-		unsigned ProgramCounter = 1;
-		if ( (Program[0] == name) && (Arguments == Program.size() - 1)) {
-			while (ProgramCounter < Program.size()) {
-				// Check if the current token has an interpretation
-				if (has_interpretation(Program[ProgramCounter])) {
-					auto interp = Evaluate(Program[ProgramCounter]);
-					if (has_interpretation(interp.first)) {
-						auto type = Evaluate(interp.first);
-						// Check if the type of the interpreted token matches the expected argument type
-						if (type.first == interp.first)
-							ProgramCounter++;
-						else return false;
-						
-					}
+	// Registers f as a command: "name a b" reads a and b as the parameter types of f, calls f with them and evaluates to what it returns, or to nothing for void.
+	// The parser of each argument is ParseValue for its parameter type, chosen at compile time, so the words go straight into the call.
+	// The syntax parses the arguments and hands them to the semantic, which only parses them itself when run without the syntax.
+	// An instruction with too few or too many arguments, or one that is not of its type, is not recognized.
+	template <typename Ret, typename... Args>
+		requires std::is_same_v<V, char8_t> && (Value<std::decay_t<Args>> && ...)
+	bool InterpretFunction(const Token<V>& name, const std::set<Medium<V>>& comms, std::function<Ret(Args...)> f) {
+		if (!Interpret(
+			Alphabet{},
+			name,
+			[comms](const Token<V>& prog) -> Reading {
+				if (!std::holds_alternative<Medium<V>>(prog)) return 0;
+				const Medium<V>& text = std::get<Medium<V>>(prog);
+				if (!comms.contains(CommandWord(text))) return 0;
+				auto arguments = Arguments<Args...>(text);
+				if (!arguments) return 0;
+				return { text.size(), std::move(*arguments) };
+			},
+			[f](const Token<V>& prog, const std::any& operands) -> std::any {
+				using Tuple = std::tuple<std::decay_t<Args>...>;
+				std::optional<Tuple> parsed;
+				const Tuple* arguments = std::any_cast<Tuple>(&operands);
+				if (arguments == nullptr) arguments = &parsed.emplace(*Arguments<Args...>(std::get<Medium<V>>(prog)));
+				if constexpr (std::is_void_v<Ret>) {
+					std::apply(f, *arguments);
+					return {};
 				}
+				else return std::apply(f, *arguments);
 			}
-			return true;
+		)) return false;
+		Alias(name, comms);
+		return true;
+	}
+
+	// The same for a plain function.
+	template <typename Ret, typename... Args>
+		requires std::is_same_v<V, char8_t> && (Value<std::decay_t<Args>> && ...)
+	bool InterpretFunction(const Token<V>& name, const std::set<Medium<V>>& comms, Ret (*f)(Args...)) {
+		return InterpretFunction(name, comms, std::function<Ret(Args...)>(f));
+	}
+
+	// The arguments of a function taking Args, read from the words of prog after its command word.
+	// Nothing unless there is exactly one word per argument and each is a value of its type.
+	template <typename... Args>
+	static std::optional<std::tuple<std::decay_t<Args>...>> Arguments(const Medium<V>& prog) {
+		std::array<std::u8string_view, sizeof...(Args)> words;
+		std::size_t pos = SkipSpace(prog, SkipWord(prog, SkipSpace(prog, 0)));
+		for (std::u8string_view& word : words) {
+			std::size_t end = SkipWord(prog, pos);
+			if (end == pos) return std::nullopt;
+			word = std::u8string_view(prog).substr(pos, end - pos);
+			pos = SkipSpace(prog, end);
 		}
-		else return false;
+		if (pos != prog.size()) return std::nullopt;
+		return Parsed<std::decay_t<Args>...>(words, std::index_sequence_for<Args...>{});
+	}
+
+	template <typename... Types, std::size_t... Is>
+	static std::optional<std::tuple<Types...>> Parsed(const std::array<std::u8string_view, sizeof...(Types)>& words, std::index_sequence<Is...>) {
+		std::tuple<std::optional<Types>...> values{ ParseValue<Types>(words[Is])... };
+		if (!(std::get<Is>(values).has_value() && ...)) return std::nullopt;
+		return std::tuple<Types...>{ std::move(*std::get<Is>(values))... };
 	}
 
 	// Helper function to interpret a token as a Name (i.e., a valid identifier in the language)
 	unsigned long long NameSyntax(const Token<V>& t, const Token<V>& program) {
 		if constexpr (Text<V> && std::is_same_v<V, char8_t>) {
-			if (str_predicate(std::isalpha, t) && t == program) {
+			if (str_name(t) && t == program) {
 				if (std::holds_alternative<Program<V>>(t)) {
 					return 1; // Single character token has length 1
 				}
@@ -699,8 +1629,7 @@ class Language {
 	unsigned long long MediumFunctionSyntax(const Token<V>& prog, const std::set<Medium<char8_t>>& comnames) {
 		if constexpr (Text<V> && std::is_same_v<V, char8_t>) {
 			if (std::holds_alternative<Medium<V>>(prog)) {
-				Medium<V> command = Lick(std::get<Medium<V>>(prog));
-				if (comnames.contains(std::get<Medium<V>>(ToLower(command)))) {
+				if (comnames.contains(CommandWord(std::get<Medium<V>>(prog)))) {
 					return std::get<Medium<V>>(prog).size();
 				}
 			}
@@ -710,17 +1639,324 @@ class Language {
 	}
 
 	std::any MediumFunctionSemantic(const Token<V>& prog, std::function<std::any(const Medium<V>&)> f) {
-		Medium<char8_t> program = std::get<Medium<char8_t>>(prog);
-		//Munch(program);
-		return f(program);
+		return f(std::get<Medium<V>>(prog));
 	}
 
 
-	std::any Evaluate(const Concept& C, const Token<V>& prog) {
-		auto [name, syn, sem] = C;
-		return sem(prog);
+	// Evaluates prog by C, with the operands the syntax of C parsed from it, if any.
+	std::any Evaluate(const Concept& C, const Token<V>& prog, const std::any& operands = {}) {
+		if constexpr (Profiling) {
+			if (&C >= I.data() && &C < I.data() + I.size()) {
+				std::size_t index = static_cast<std::size_t>(&C - I.data());
+				auto begin = std::chrono::steady_clock::now();
+				std::any result = std::get<2>(C)(prog, operands);
+				ConceptProfile& p = profiler.At(index);
+				p.semantictime += Since(begin);
+				++p.evaluated;
+				return result;
+			}
+		}
+		return std::get<2>(C)(prog, operands);
+	}
+
+};
+
+// Statistics is what the machine records about its own execution.
+// The counters are plain integers bumped on the hot path; exporting them is left to ToJSON and Write.
+// Instructions are counted per concept by the position of the concept in its language, and only named when they are reported.
+// The work of the machine falls in three phases: loading programs (and installing images), decoding them ahead of time, and running them.
+// Each phase is charged the wall time spent in it and the allocations the machine made in it: tapes, scratch tokens and decoded programs.
+struct Statistics {
+	enum class Phase : unsigned char { None, Load, Decode, Run };
+
+	unsigned long long instructions = 0; // instructions evaluated
+	std::vector<std::vector<unsigned long long>> executed; // instructions evaluated per concept: by language, the machine's first and then every resource's, and by rule
+	unsigned long long calls = 0;
+	unsigned long long depth = 0; // maximum call depth reached
+	unsigned long long growths = 0; // MoreTape events
+	unsigned long long shrinks = 0; // Shrink events
+	unsigned long long copied = 0; // bytes copied by MoreTape and Shrink
+	unsigned long long order = 0; // peak tape order
+	unsigned long long allocations = 0; // tapes allocated
+	unsigned long long allocated = 0; // bytes of tape allocated
+	unsigned long long loadtime = 0; // nanoseconds spent loading programs
+	unsigned long long runtime = 0; // nanoseconds spent running them
+	unsigned long long macrosteps = 0; // macro steps replayed instead of evaluated
+	unsigned long long simulated = 0; // instructions the replayed macro steps stand for
+	unsigned long long decodetime = 0; // nanoseconds spent decoding programs ahead of time
+	unsigned long long loadallocations = 0; // allocations made while loading
+	unsigned long long decodeallocations = 0; // while decoding
+	unsigned long long runallocations = 0; // and while running
+
+	// Names the concept of rule in the language at index resource (-1 for the machine's), set by the machine that owns the record.
+	std::function<Medium<char8_t>(std::int32_t resource, std::uint32_t rule)> namer;
+
+	Phase phase = Phase::None; // the phase time and allocations are charged to
+	std::chrono::steady_clock::time_point since{}; // when it was last entered or resumed
+
+	// Charges the time from construction to destruction, and the allocations made meanwhile, to a phase.
+	// A phase begun inside another pauses it, so a load made by a running program is not counted as run time too.
+	class Timer {
+	public:
+		Timer(Statistics& s, Phase p) : stats(s), outer(s.Enter(p)) {}
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+		~Timer() { stats.Enter(outer); }
+
+	private:
+		Statistics& stats;
+		Phase outer;
+	};
+
+	// Charges the time since the current phase was entered to it and makes next the current phase. Returns the one it replaces.
+	Phase Enter(Phase next) {
+		auto now = std::chrono::steady_clock::now();
+		auto ns = static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - since).count());
+		if (phase == Phase::Load) loadtime += ns;
+		else if (phase == Phase::Decode) decodetime += ns;
+		else if (phase == Phase::Run) runtime += ns;
+		since = now;
+		Phase previous = phase;
+		phase = next;
+		return previous;
+	}
+
+	void Allocation() {
+		if (phase == Phase::Load) ++loadallocations;
+		else if (phase == Phase::Decode) ++decodeallocations;
+		else if (phase == Phase::Run) ++runallocations;
+	}
+
+	void Executed(std::int32_t resource, std::uint32_t rule) {
+		std::size_t lang = static_cast<std::size_t>(resource + 1);
+		if (lang >= executed.size()) executed.resize(lang + 1);
+		std::vector<unsigned long long>& counts = executed[lang];
+		if (rule >= counts.size()) counts.resize(rule + 1);
+		++counts[rule];
+	}
+
+	// The instructions evaluated per concept, by name. Concepts of the same name in different languages are counted together.
+	std::map<Medium<char8_t>, unsigned long long> PerConcept() const {
+		std::map<Medium<char8_t>, unsigned long long> counts;
+		for (std::size_t lang = 0; lang < executed.size(); ++lang) {
+			for (std::uint32_t rule = 0; rule < executed[lang].size(); ++rule) {
+				if (executed[lang][rule] == 0) continue;
+				std::int32_t resource = static_cast<std::int32_t>(lang) - 1;
+				Medium<char8_t> name;
+				if (namer) name = namer(resource, rule);
+				else {
+					std::string number = std::to_string(resource) + ":" + std::to_string(rule);
+					name.assign(number.begin(), number.end());
+				}
+				counts[name] += executed[lang][rule];
+			}
+		}
+		return counts;
+	}
+
+	// Zeroes every counter. The record stays with its machine, and a phase under way goes on being timed from now.
+	void Clear() {
+		Statistics cleared;
+		cleared.namer = std::move(namer);
+		cleared.phase = phase;
+		cleared.since = std::chrono::steady_clock::now();
+		*this = std::move(cleared);
+	}
+
+	std::string ToJSON() const {
+		std::string json = "{";
+		auto field = [&json](const char* name, unsigned long long value) {
+			json += "\"";
+			json += name;
+			json += "\":";
+			json += std::to_string(value);
+			json += ",";
+		};
+		field("instructions", instructions);
+		field("calls", calls);
+		field("depth", depth);
+		field("growths", growths);
+		field("shrinks", shrinks);
+		field("copied", copied);
+		field("order", order);
+		field("allocations", allocations);
+		field("allocated", allocated);
+		field("loadtime", loadtime);
+		field("runtime", runtime);
+		field("macrosteps", macrosteps);
+		field("simulated", simulated);
+		field("decodetime", decodetime);
+		field("loadallocations", loadallocations);
+		field("decodeallocations", decodeallocations);
+		field("runallocations", runallocations);
+		json += "\"executed\":{";
+		bool first = true;
+		for (const auto& [name, count] : PerConcept()) {
+			if (!first) json += ",";
+			first = false;
+			json += "\"";
+			for (char8_t c : name) {
+				if (c == u8'"' || c == u8'\\') json += '\\';
+				if (c < 0x20) {
+					char buffer[8];
+					std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+					json += buffer;
+				}
+				else json += static_cast<char>(c);
+			}
+			json += "\":";
+			json += std::to_string(count);
+		}
+		json += "}}";
+		return json;
+	}
+
+	// The compact record is the magic "AMST", a version byte, the fixed counters as little-endian 64-bit integers in declaration order,
+	// then the number of concepts followed by each concept as a 32-bit name length, the name, and its 64-bit count.
+	void Write(std::ostream& os) const {
+		auto u64 = [&os](unsigned long long value) {
+			for (int i = 0; i < 8; ++i) os.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+		};
+		os.write("AMST", 4);
+		os.put(3);
+		for (unsigned long long value : { instructions, calls, depth, growths, shrinks, copied, order, allocations, allocated, loadtime, runtime, macrosteps, simulated,
+			decodetime, loadallocations, decodeallocations, runallocations }) {
+			u64(value);
+		}
+		const std::map<Medium<char8_t>, unsigned long long> counts = PerConcept();
+		u64(counts.size());
+		for (const auto& [n, count] : counts) {
+			for (int i = 0; i < 4; ++i) os.put(static_cast<char>((n.size() >> (8 * i)) & 0xFF));
+			os.write(reinterpret_cast<const char*>(n.data()), static_cast<std::streamsize>(n.size()));
+			u64(count);
+		}
+	}
+
+	// Looks a counter up by name, as the stats command does.
+	std::optional<unsigned long long> Counter(const Medium<char8_t>& name) const {
+		if (name == u8"instructions") return instructions;
+		if (name == u8"calls") return calls;
+		if (name == u8"depth") return depth;
+		if (name == u8"growths") return growths;
+		if (name == u8"shrinks") return shrinks;
+		if (name == u8"copied") return copied;
+		if (name == u8"order") return order;
+		if (name == u8"allocations") return allocations;
+		if (name == u8"allocated") return allocated;
+		if (name == u8"loadtime") return loadtime;
+		if (name == u8"runtime") return runtime;
+		if (name == u8"macrosteps") return macrosteps;
+		if (name == u8"simulated") return simulated;
+		if (name == u8"decodetime") return decodetime;
+		if (name == u8"loadallocations") return loadallocations;
+		if (name == u8"decodeallocations") return decodeallocations;
+		if (name == u8"runallocations") return runallocations;
+		const std::map<Medium<char8_t>, unsigned long long> counts = PerConcept();
+		auto found = counts.find(name);
+		if (found != counts.end()) return found->second;
+		return std::nullopt;
 	}
 
+	static Medium<char8_t> Name(const Token<char8_t>& token) {
+		if (std::holds_alternative<Program<char8_t>>(token)) return Medium<char8_t>(1, std::get<Program<char8_t>>(token));
+		return std::get<Medium<char8_t>>(token);
+	}
+};
+
+// StateProfile samples the call chain of the machine once every period instructions.
+// A sample is charged to the whole chain, outermost state first, with the instructions and the time since the previous sample.
+struct StateProfile {
+	struct Weight {
+		unsigned long long samples = 0;
+		unsigned long long instructions = 0;
+		unsigned long long time = 0; // nanoseconds
+
+		Weight& operator+=(const Weight& other) {
+			samples += other.samples;
+			instructions += other.instructions;
+			time += other.time;
+			return *this;
+		}
+	};
+
+	// How hot one state is: self counts the samples taken in it, total those taken in it or in a state it called.
+	struct Hotness {
+		unsigned long long state;
+		Weight self;
+		Weight total;
+	};
+
+	unsigned long long period = 0; // instructions between samples; 0 turns sampling off
+	unsigned long long countdown = 0;
+	std::map<std::vector<unsigned long long>, Weight> stacks;
+	std::chrono::steady_clock::time_point last;
+
+	void Start(unsigned long long every) {
+		stacks.clear();
+		period = countdown = every;
+		last = std::chrono::steady_clock::now();
+	}
+
+	void Stop() { period = 0; }
+
+	void Sample(const std::vector<unsigned long long>& previous, unsigned long long state) {
+		auto now = std::chrono::steady_clock::now();
+		std::vector<unsigned long long> stack = previous;
+		stack.push_back(state);
+		Weight& w = stacks[stack];
+		++w.samples;
+		w.instructions += period;
+		w.time += static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+		last = now;
+		countdown = period;
+	}
+
+	// Every sampled state, hottest first.
+	std::vector<Hotness> Table() const {
+		std::map<unsigned long long, Hotness> table;
+		for (const auto& [stack, w] : stacks) {
+			Hotness& self = table.try_emplace(stack.back(), Hotness{ stack.back(), {}, {} }).first->second;
+			self.self += w;
+			// a recursive state is charged once per sample
+			std::set<unsigned long long> seen(stack.begin(), stack.end());
+			for (unsigned long long st : seen) table.try_emplace(st, Hotness{ st, {}, {} }).first->second.total += w;
+		}
+		std::vector<Hotness> hot;
+		for (const auto& [st, h] : table) hot.push_back(h);
+		std::stable_sort(hot.begin(), hot.end(), [](const Hotness& a, const Hotness& b) { return a.self.instructions > b.self.instructions; });
+		return hot;
+	}
+
+	// One line per call chain, "outer;inner;state count", the folded format flame graph tools read.
+	// Counts are instructions, or nanoseconds if time is set. A non-empty root is prefixed to every chain.
+	void WriteFolded(std::ostream& os, const std::function<std::string(unsigned long long)>& name, bool time = false, const std::string& root = "") const {
+		for (const auto& [stack, w] : stacks) {
+			os << root;
+			for (std::size_t i = 0; i < stack.size(); ++i) os << (i > 0 || !root.empty() ? ";" : "") << name(stack[i]);
+			os << ' ' << (time ? w.time : w.instructions) << '\n';
+		}
+	}
+
+	void WriteTable(std::ostream& os, const std::function<std::string(unsigned long long)>& name) const {
+		unsigned long long all = 0;
+		for (const auto& [stack, w] : stacks) all += w.instructions;
+		os << "state\tself\tself %\ttotal\ttotal %\tself ns\n";
+		for (const Hotness& h : Table()) {
+			os << name(h.state) << '\t' << h.self.instructions << '\t' << (all ? 100.0 * static_cast<double>(h.self.instructions) / static_cast<double>(all) : 0.0) << '\t'
+				<< h.total.instructions << '\t' << (all ? 100.0 * static_cast<double>(h.total.instructions) / static_cast<double>(all) : 0.0) << '\t' << h.self.time << '\n';
+		}
+	}
+};
+
+// An Instruction is a step of a state's program decoded ahead of time: where its text lies, and the concept that recognized it.
+// Running it evaluates that concept straight away, without trying the languages again. Offsets are into the state's program.
+struct Instruction {
+	std::uint32_t begin; // where the instruction starts
+	std::uint32_t length; // characters it consumes, with any resource prefix
+	std::uint32_t operand; // where the text handed to the concept starts
+	std::uint32_t size; // and its length
+	std::int32_t resource; // index into the machine's Resources, or -1 for the machine language
+	std::uint32_t rule; // index of the concept in that language's interpretation
 };
 
 class Resource {
@@ -748,12 +1984,16 @@ public:
 	States() {
 
 		language.AddCharacterInterpretations();
-		language.InterpretMediumFunction(u8"load", ld, [this](const Medium<char8_t>& p) { return this->Load(p); });
+		language.InterpretMediumFunction(u8"load", ld, [this](const Medium<char8_t>& p) {
+			Medium<char8_t> prog = p;
+			language.Munch(prog); // Remove "load" command
+			return this->Load(prog);
+		});
 		language.InterpretMediumFunction(u8"unload", ud, [this](const Medium<char8_t>& p) { return this->Unload(p); });
 
 
 		language.InterpretMediumFunction(u8"accepting", ag, [this](const Medium<char8_t>& p) { return this->AcceptingSemantic(p); });
-		language.InterpretMediumFunction(u8"state", se, [this](const Medium<char8_t>& p) { return this->State(); });
+		language.InterpretMediumFunction(u8"state", se, [this](const Medium<char8_t>&) { return this->State(); });
 	}
 
 
@@ -773,34 +2013,66 @@ public:
 	std::vector<unsigned long long> instnum{}; //Instruction number stack
 	std::vector<unsigned long long> previous{}; //Previous state stack for backtracking
 	std::set<unsigned long long> accepting{};
+	std::map<unsigned long long, Medium<char8_t>> named{}; // states defined with "name", and their names. They are reached by call or jump rather than run when loaded
+	std::unordered_map<unsigned long long, std::vector<Instruction>> decoded{}; // programs decoded ahead of time, as a program image installs them
+	unsigned long long edits = 0; // how many times a program was defined or removed, so what was learnt from the old ones can be dropped
+
+	// The decoded program of st, or nullptr if it has to be recognized as it runs.
+	const std::vector<Instruction>* Decoded(unsigned long long st) const {
+		auto found = decoded.find(st);
+		return found == decoded.end() ? nullptr : &found->second;
+	}
 
 	unsigned long long State() const { return state; }
 
+	// Forgets what was derived from the program of st, which was just defined or removed.
+	void Changed(unsigned long long st) {
+		decoded.erase(st);
+		++edits;
+	}
+
+	// Drops the program of st, and what was derived from it.
+	void Erase(unsigned long long st) {
+		states.erase(st);
+		Changed(st);
+	}
+
 	// Load returns a pair of the state kind and the new state number. 
-	std::pair<StateKind,unsigned long long> Load(const Token<char8_t>& program) {
-		Medium<char8_t> prog = std::get<Medium<char8_t>>(program);
+	// The program is taken by value so a caller done with its line can move it into the state table.
+	std::pair<StateKind,unsigned long long> Load(Token<char8_t> program) {
+		Medium<char8_t> prog = std::get<Medium<char8_t>>(std::move(program));
 		StateKind kind = StateKind::NL;
 		Medium<char8_t> name;
 		unsigned long long new_state;
 
-		if (at.contains(std::get<Medium<char8_t>>(ToLower(language.Lick(prog))))) {
+		if (at.contains(Language<char8_t>::CommandWord(prog))) {
 			kind = StateKind::AG;
 			language.Munch(prog); // Remove "accept"
 		}
 
 		if (!prog.empty()){
-			if(ne.contains(std::get<Medium<char8_t>>(ToLower(language.Lick(prog))))) {
+			if(ne.contains(Language<char8_t>::CommandWord(prog))) {
 				language.Munch(prog); // Remove "name"	
 				if (!prog.empty()){
 					name = language.Munch(prog);
-					if (!name.empty() && str_predicate(std::isalpha, name)) {
+					if (!name.empty() && str_name(name)) {
+						// The rest of the line is the program of the named state; it may be empty.
 						new_state = hasher(name);
+						states[new_state] = std::move(prog);
+						Changed(new_state);
+						named[new_state] = name;
+						if (kind == StateKind::AG) {
+							Accept(new_state);
+						}
+						return std::make_pair(kind, new_state);
 					} 
 				}
+				return std::make_pair(StateKind::ER, 0); // Invalid name
 			}
-			else if (st.contains(std::get<Medium<char8_t>>(ToLower(language.Lick(prog))))) {
+			else if (st.contains(Language<char8_t>::CommandWord(prog))) {
 				new_state = 0;
 				language.Munch(prog); // Remove "start"
+				Changed(new_state);
 				if (!prog.empty()) {
 					states[new_state] = prog; // Store the remaining program as the state representation
 				}
@@ -824,7 +2096,8 @@ public:
 			return std::make_pair(StateKind::ER, 0); // Invalid name
 		}
 		
-		states[new_state] = prog;
+		states[new_state] = std::move(prog);
+		Changed(new_state);
 		if (kind == StateKind::AG) {
 			Accept(new_state);
 		}
@@ -842,19 +2115,21 @@ public:
 		else {
 			prog = language.Munch(prog); // Get the next token which should be the state identifier
 			if (!prog.empty()) {
-				if( str_predicate(std::isalpha, prog)) {
+				if( str_name(prog)) {
 					s = hasher(prog);
 				}
 				else if( str_predicate(std::isdigit, prog)) {
 					s = std::stoull(std::string(prog.begin(), prog.end()));
 				}
+				else return 0; // Invalid state identifier
 			}
 			else return 0; // Invalid state identifier
 		}
 		if (states.contains(s)) {
-			states.erase(s);
+			Erase(s);
 			if (accepting.contains(s))
 				accepting.erase(s);
+			named.erase(s);
 			if (state == s) {
 				state = previous.empty() ? 0 : previous.back();
 				if (!previous.empty()) {
@@ -877,7 +2152,7 @@ public:
 		if (!prog.empty()) {
 			prog = language.Munch(prog); // Get the next token which should be the state identifier
 			if (!prog.empty()) {
-				if( str_predicate(std::isalpha, prog)) {
+				if( str_name(prog)) {
 					unsigned long s = hasher(prog);
 					return Accepting(s);
 				}
@@ -917,13 +2192,34 @@ public:
 	std::set<Medium<char8_t>> gotocomms = {u8"goto", u8"go"};
 	std::set<Medium<char8_t>> shrinkcomms = {u8"shrink", u8"sk"};
 	std::set<Medium<char8_t>> movecomms = {u8"move", u8"me"};
-
+	std::set<Medium<char8_t>> seekcomms = {u8"seek"}; // "sk" is shrink
+	std::set<Medium<char8_t>> countcomms = {u8"count", u8"ct"};
+	std::set<Medium<char8_t>> findcomms = {u8"find", u8"fd"};
+	std::set<Medium<char8_t>> addcomms = {u8"add", u8"ad"};
+	std::set<Medium<char8_t>> multiplycomms = {u8"multiply", u8"my"};
+	std::set<Medium<char8_t>> andcomms = {u8"and"}; // "ad" is add
+	std::set<Medium<char8_t>> orcomms = {u8"or"};
+	std::set<Medium<char8_t>> scancomms = {u8"scan", u8"sn"};
+	std::set<Medium<char8_t>> sumcomms = {u8"sum"}; // "sm" is the machine's system
+	std::set<Medium<char8_t>> mincomms = {u8"min", u8"mn"};
+	std::set<Medium<char8_t>> maxcomms = {u8"max", u8"mx"};
+
+
+	// The cell operand of goto and move: the word after the command.
+	long long Operand(const Medium<char8_t>& prog) {
+		std::size_t pos = 0;
+		language.Bite(prog, pos); // Skip the command
+		Medium<char8_t> operand = language.Bite(prog, pos);
+		return std::stoll(std::string(operand.begin(), operand.end()));
+	}
 
 	Medium<V> Tape;
 
 	long long head; 
 	unsigned char order;
 
+	Statistics* stats = nullptr; // set by the machine that owns this substrate
+
 
 	Substrate() {
 		order = 16;
@@ -955,14 +2251,32 @@ public:
 		language.InterpretNullaryVoidFunction(u8"shrink", shrinkcomms, [this]() { Shrink(); });
 
 		language.Interpret(
-			std::set<char8_t>{},
+			CharClass{},
 			u8"write",
-			[this](const Token<char8_t>& prog) { return this->WriteSyntax(prog); },
-			[this](const Token<char8_t>& prog) { return this->WriteSemantic(prog); }
+			[this](const Token<char8_t>& prog) { return this->MatchWrite(prog).value_or(Language<char8_t>::Rejected); },
+			[this](const Token<char8_t>& prog, const std::any& value) { return this->WriteSemantic(prog, value); }
 		);
+		language.Alias(u8"write", writecomms);
+
+		language.InterpretMediumFunction(u8"goto", gotocomms, [this](const Medium<char8_t>& prog) { return this->GoTo(Operand(prog)); });
+		language.InterpretMediumFunction(u8"move", movecomms, [this](const Medium<char8_t>& prog) { return this->Move(Operand(prog)); });
 
-		language.InterpretMediumFunction(u8"goto", gotocomms, [this](const Medium<char8_t>& prog) { return this->GoTo(std::stoll(std::string(prog.begin(), prog.end()))); });
-		language.InterpretMediumFunction(u8"move", movecomms, [this](const Medium<char8_t>& prog) { return this->Move(std::stoll(std::string(prog.begin(), prog.end()))); });
+		language.InterpretMediumFunction(u8"seek", seekcomms, [this](const Medium<char8_t>& prog) { return this->SeekSemantic(prog); });
+		language.InterpretMediumFunction(u8"count", countcomms, [this](const Medium<char8_t>& prog) { return this->CountSemantic(prog); });
+		language.InterpretMediumFunction(u8"find", findcomms, [this](const Medium<char8_t>& prog) { return this->FindSemantic(prog); });
+
+		if constexpr (Numeric) {
+			language.InterpretMediumFunction(u8"add", addcomms, [this](const Medium<char8_t>& prog) { return this->MapSemantic(Operation::Add, prog); });
+			language.InterpretMediumFunction(u8"multiply", multiplycomms, [this](const Medium<char8_t>& prog) { return this->MapSemantic(Operation::Multiply, prog); });
+			if constexpr (std::integral<V>) {
+				language.InterpretMediumFunction(u8"and", andcomms, [this](const Medium<char8_t>& prog) { return this->MapSemantic(Operation::And, prog); });
+				language.InterpretMediumFunction(u8"or", orcomms, [this](const Medium<char8_t>& prog) { return this->MapSemantic(Operation::Or, prog); });
+			}
+			language.InterpretMediumFunction(u8"scan", scancomms, [this](const Medium<char8_t>& prog) { return this->ReduceSemantic(u8"scan", prog); });
+			language.InterpretMediumFunction(u8"sum", sumcomms, [this](const Medium<char8_t>& prog) { return this->ReduceSemantic(u8"sum", prog); });
+			language.InterpretMediumFunction(u8"min", mincomms, [this](const Medium<char8_t>& prog) { return this->ReduceSemantic(u8"min", prog); });
+			language.InterpretMediumFunction(u8"max", maxcomms, [this](const Medium<char8_t>& prog) { return this->ReduceSemantic(u8"max", prog); });
+		}
 	}
 
 
@@ -998,10 +2312,13 @@ public:
 	// 	return std::any{};
 	// }
 
-	std::any WriteSemantic(const Token<char8_t>& prog) {
-		Medium<char8_t> program = std::get<Medium<char8_t>>(prog);
-		language.Munch(program); // Remove "write" command
-		Medium<char8_t> valStr = language.Munch(program); // Get the data to write
+	// value is the V MatchWrite parsed, if it ran; otherwise the value is read from prog.
+	std::any WriteSemantic(const Token<char8_t>& prog, const std::any& value = {}) {
+		if (const V* parsed = std::any_cast<V>(&value)) return Write(*parsed);
+
+		std::size_t pos = 0;
+		language.Bite(std::get<Medium<char8_t>>(prog), pos); // Skip "write" command
+		Medium<char8_t> valStr = language.Bite(std::get<Medium<char8_t>>(prog), pos); // Get the data to write
 
 		// Case 0: Tape stores bool values
 		if constexpr (std::is_same_v<V, bool>) {
@@ -1018,8 +2335,8 @@ public:
 		// Case 1: The Tape stores full Strings
 		else if constexpr (String<V>) {
 			// Program<V> is V, which is a string type.
-			// We can pass valStr (Medium<char8_t>) directly or cast it.
-			return Write(V(valStr)); 
+			// valStr is ours, so it is moved into the value rather than copied.
+			return Write(V(std::move(valStr)));
 		} 
 		// Case 2: The Tape stores single Characters
 		else if constexpr (Char<V>) {
@@ -1027,10 +2344,11 @@ public:
 				return Write(static_cast<V>(valStr[0]));
 			}
 			// Fallback for numeric codes (e.g., "65" -> 'A')
-			try {
-				std::string s(reinterpret_cast<const char*>(valStr.data()), valStr.size());
-				return Write(static_cast<V>(std::stoi(s)));
-			} catch (...) { return std::any{}; }
+			const char* first = reinterpret_cast<const char*>(valStr.data());
+			int code = 0;
+			auto [ptr, ec] = std::from_chars(first, first + valStr.size(), code);
+			if (ec != std::errc{} || ptr != first + valStr.size()) return std::any{};
+			return Write(static_cast<V>(code));
 		}
 		// Case 3: The Tape stores Numbers (int, long long, etc.)
 		else if constexpr (Arithmetic<V>) {
@@ -1040,6 +2358,7 @@ public:
 			V numericVal = 0;
 
 			auto [ptr, ec] = std::from_chars(first, last, numericVal);
+			if (ec == std::errc{} && ptr != last) ec = std::errc::invalid_argument; // trailing characters
 
 			if (ec == std::errc{}) {
 				return Write(numericVal);
@@ -1049,9 +2368,14 @@ public:
 				else if (ec == std::errc::result_out_of_range)
 					std::cout << "This number is larger than an int.\n";
 				// Handle error: result was out of range or not a number
-				return std::any{ptr, ec}; // Return parsing result for debugging
+				return std::any(ec); // Return the parsing error for debugging
 			}
 		}
+		// Case 4: The Tape stores a Defined type, built from the text
+		else if constexpr (Defined<V>) {
+			if (std::optional<V> value = Parse(valStr)) return Write(*value);
+			return std::any{};
+		}
 
 		return std::any{};
 	}
@@ -1089,42 +2413,48 @@ public:
 
 
 	unsigned long long WriteSyntax(const Token<char8_t>& prog) {
+		std::expected<unsigned long long, Unrecognized> taken = MatchWrite(prog);
+		if (!taken) throw std::invalid_argument("No value provided to write\n");
+		return *taken;
+	}
+
+	// WriteSyntax for the language: a write without a value, or with one that is not a V, is Malformed instead of an exception.
+	// The value is parsed here and handed to WriteSemantic with the length, so a write reads its value once.
+	std::expected<Language<char8_t>::Reading, Unrecognized> MatchWrite(const Token<char8_t>& prog) {
 		if (!std::holds_alternative<Medium<char8_t>>(prog)) return 0;
 
 		const Medium<char8_t>& medium = std::get<Medium<char8_t>>(prog);
 		auto [commandToken, cmdConsumed] = language.Lunch(medium);
 
 		// command must be a write command and there must be data after it
-		if (!writecomms.contains(std::get<Medium<char8_t>>(ToLower(commandToken))) || medium.size() <= cmdConsumed) {
-			if (medium.size() <= cmdConsumed) throw std::invalid_argument("No value provided to write\n");
-			return 0;
-		}
+		if (!writecomms.contains(std::get<Medium<char8_t>>(ToLower(std::move(commandToken))))) return 0;
+		if (medium.size() <= cmdConsumed) return std::unexpected(Unrecognized::Malformed);
 
 		// remaining buffer after the command
 		Medium<char8_t> remaining(medium.begin() + static_cast<std::ptrdiff_t>(cmdConsumed), medium.end());
 		auto [valueToken, valConsumed] = language.Lunch(remaining);
 
-		if (valueToken.empty()) throw std::invalid_argument("No value provided to write\n");
+		if (valueToken.empty()) return std::unexpected(Unrecognized::Malformed);
 
-		bool convertible = false;
+		std::optional<V> value;
 
-		// --- Check convertibility to V without performing the write ---
+		// --- Parse the value as a V without performing the write ---
 		if constexpr (std::is_same_v<V, bool>) {
 			// Use ToLower to canonicalize boolean strings
 			Token<char8_t> vt = valueToken;
 			auto lowered = ToLower(vt);
 			auto lowerMedium = std::get<Medium<char8_t>>(lowered);
 			std::u8string lower_s(lowerMedium.begin(), lowerMedium.end());
-			if (lower_s == u8"true" || lower_s == u8"1" || lower_s == u8"false" || lower_s == u8"0")
-				convertible = true;
+			if (lower_s == u8"true" || lower_s == u8"1") value = true;
+			else if (lower_s == u8"false" || lower_s == u8"0") value = false;
 		}
 		else if constexpr (String<V>) {
 			// any token can be treated as a string-like V
-			convertible = true;
+			value = V(std::move(valueToken));
 		}
 		else if constexpr (Char<V>) {
 			// single character token OK
-			if (valueToken.size() == 1) convertible = true;
+			if (valueToken.size() == 1) value = static_cast<V>(valueToken[0]);
 			else {
 				// numeric-code fallback, parse as signed integer then range-check for V
 				std::string s;
@@ -1133,18 +2463,18 @@ public:
 
 				long long tmp = 0;
 				auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), tmp);
-				if (ec == std::errc{}) {
+				if (ec == std::errc{} && ptr == s.data() + s.size()) { // the whole token, so "12abc" is not 12
 					using Target = std::remove_cv_t<V>;
 					if constexpr (std::is_signed_v<Target>) {
 						long long tmin = static_cast<long long>(std::numeric_limits<Target>::min());
 						long long tmax = static_cast<long long>(std::numeric_limits<Target>::max());
-						if (tmp >= tmin && tmp <= tmax) convertible = true;
+						if (tmp >= tmin && tmp <= tmax) value = static_cast<V>(tmp);
 					}
 					else {
 						if (tmp >= 0) {
 							unsigned long long utmp = static_cast<unsigned long long>(tmp);
 							unsigned long long umax = static_cast<unsigned long long>(std::numeric_limits<Target>::max());
-							if (utmp <= umax) convertible = true;
+							if (utmp <= umax) value = static_cast<V>(tmp);
 						}
 					}
 				}
@@ -1157,22 +2487,15 @@ public:
 			for (char8_t c : valueToken) s.push_back(static_cast<char>(c));
 			V numericVal = 0;
 			auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), numericVal);
-			if (ec == std::errc{}) convertible = true;
+			if (ec == std::errc{} && ptr == s.data() + s.size()) value = numericVal;
 		}
 		else if constexpr (Defined<V>) {
-			// try constructing V from the token
-			try {
-				std::u8string s(valueToken.begin(), valueToken.end());
-				(void)V(s);
-				convertible = true;
-			}
-			catch (...) {
-				convertible = false;
-			}
+			value = Parse(valueToken);
 		}
 
-		// return total consumed length (command + value) when convertible, else 0
-		return convertible ? (cmdConsumed + valConsumed) : 0;
+		// the total consumed length (command + value) and the value, which must be a V
+		if (!value) return std::unexpected(Unrecognized::Malformed);
+		return Language<char8_t>::Reading{ cmdConsumed + valConsumed, std::move(*value) };
 	}
 
 	
@@ -1186,11 +2509,31 @@ public:
 		return Head();
 	}*/
 
+	// The bytes n cells take.
+	static std::size_t Bytes(std::size_t n) {
+		if constexpr (requires { Medium<V>::Bytes(n); }) return Medium<V>::Bytes(n);
+		else return n * sizeof(typename Medium<V>::value_type);
+	}
+
+	// Copies n cells of from, from source on, to the cells of to from target on.
+	static void CopyCells(Medium<V>& to, std::size_t target, const Medium<V>& from, std::size_t source, std::size_t n) {
+		if constexpr (requires { to.Copy(target, from, source, n); }) to.Copy(target, from, source, n);
+		else {
+			for (std::size_t i = 0; i < n; ++i) to[target + i] = from[source + i];
+		}
+	}
+
 	//friend class AbstractMachine;
 	Medium<V> MakeTape(const unsigned char & k) {
 		//if (k >= (sizeof(unsigned) * 8)) throw std::overflow_error("Tape order too large");
 		if (k >= 64) throw std::overflow_error("Tape order too large");
 		std::size_t size = std::size_t(1) << k;
+		if (stats != nullptr) {
+			stats->Allocation();
+			++stats->allocations;
+			stats->allocated += Bytes(size);
+			stats->order = std::max<unsigned long long>(stats->order, k);
+		}
 		if constexpr (requires { typename V::inner_type; }) {
 			using Inner = typename V::inner_type;
 			if constexpr (std::is_arithmetic_v<Inner>) {
@@ -1243,6 +2586,7 @@ public:
 			zero = static_cast<std::int64_t>(Tape.size()) / 2;
 			idx = head + zero;
 		}
+		if (hashing) hash ^= KeyAt(head) ^ Key(head, a);
 		if constexpr (requires { typename V::inner_type; }) {
 			Tape[static_cast<std::size_t>(idx)] = a.value;
 			return true;
@@ -1254,8 +2598,88 @@ public:
 		return false;
 	}
 
+	// The symbol in cell, without moving the head. Cells off the tape are blank.
+	V At(long long cell) {
+		std::int64_t idx = cell + static_cast<std::int64_t>(Tape.size()) / 2;
+		if (idx < 0 || static_cast<std::size_t>(idx) >= Tape.size()) return V{};
+		if constexpr (requires { typename V::inner_type; }) return V(Tape[static_cast<std::size_t>(idx)]);
+		else return Tape[static_cast<std::size_t>(idx)];
+	}
+
+	// Writes a into cell, growing the tape to it, and leaves the head where it was.
+	bool Put(long long cell, const Program<V>& a) {
+		long long h = head;
+		bool written = GoTo(cell) && Write(a);
+		head = h;
+		return written;
+	}
+
 	long long Head() const { return head; }
-	
+
+	// Zobrist hashing. hash is the XOR of a key for every cell that is not blank, drawn from its position and its symbol,
+	// and once hashing is on every write updates it, so Hash costs the same on any tape. Keys go by the cell, not by where it sits in Tape,
+	// so growing and shrinking the tape leave hash as it is, and the blank cells off the tape count as the blank cells on it.
+	// Hashing turns itself on the first time Hash is asked for, so a tape nobody hashes pays nothing for it.
+	std::uint64_t hash = 0;
+	bool hashing = false;
+
+	static std::uint64_t Mix(std::uint64_t x) { // splitmix64
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+
+	static std::uint64_t SymbolHash(const V& symbol) {
+		if constexpr (Columnar<V>) {
+			std::uint64_t h = 0;
+			std::apply([&](auto... member) { ((h = Mix(h ^ std::hash<std::remove_cvref_t<decltype(symbol.*member)>>{}(symbol.*member))), ...); }, Fields<V>::members);
+			return h;
+		}
+		else if constexpr (requires { typename V::inner_type; }) return std::hash<typename V::inner_type>{}(symbol.value);
+		else if constexpr (requires { std::hash<V>{}(symbol); }) return std::hash<V>{}(symbol);
+		else return 1; // a symbol type without a hash: only blank and not blank are told apart
+	}
+
+	static std::uint64_t Key(long long cell, const V& symbol) {
+		if (symbol == V{}) return 0;
+		return Mix(Mix(static_cast<std::uint64_t>(cell)) ^ SymbolHash(symbol));
+	}
+
+	// The key of what cell holds now. Interned strings are hashed in the pool, without copying them out.
+	std::uint64_t KeyAt(long long cell) {
+		if constexpr (requires { Tape.Pool().Text(Tape.Handle(0)); }) {
+			std::int64_t idx = cell + static_cast<std::int64_t>(Tape.size()) / 2;
+			if (idx < 0 || static_cast<std::size_t>(idx) >= Tape.size()) return 0;
+			std::uint32_t handle = Tape.Handle(static_cast<std::size_t>(idx));
+			if (handle == 0) return 0;
+			return Mix(Mix(static_cast<std::uint64_t>(cell)) ^ std::hash<V>{}(Tape.Pool().Text(handle)));
+		}
+		else return Key(cell, At(cell));
+	}
+
+	// The keys of the cells from first to last, XORed.
+	std::uint64_t Keys(long long first, long long last) {
+		std::uint64_t keys = 0;
+		for (long long c = first; c <= last; ++c) keys ^= KeyAt(c);
+		return keys;
+	}
+
+	// The cells and the head, as one number: equal tapes with their heads on the same cell hash the same.
+	std::uint64_t Hash() {
+		if (!hashing) {
+			Rehash();
+			hashing = true;
+		}
+		return hash ^ Mix(static_cast<std::uint64_t>(head) ^ 0x68656164ULL);
+	}
+
+	// Recomputes hash from every cell, for code that writes Tape directly.
+	void Rehash() {
+		const long long zero = static_cast<long long>(Tape.size()) / 2;
+		hash = Keys(-zero, zero - 1);
+	}
+
 	bool Left() {
 		if (--head < -(1LL << (order - 1))) {
 			if (MoreTape() == false)
@@ -1280,137 +2704,870 @@ public:
 	}
 
 	bool Move(const long long& c) {
-		long long zero = 1LL << (order - 1);
-		while ((zero + c + head) >= static_cast<long long>(Tape.size())) {
-			if (MoreTape() == false)
-				return false;
-		}
-		head += c;
-		if (head <= std::numeric_limits<long long>::max() && head >= std::numeric_limits<long long>::min())
-			return true;
-		else 
-			return false;
+		return GoTo(head + c);
 	}
 
 	bool GoTo(const long long& s) {
-		long long zero = 1LL << (order - 1);
-		while (zero + s >= static_cast<long long>(Tape.size())) {
+		// grow until the cell is on the tape, on whichever side of zero it is
+		while (s >= (1LL << (order - 1)) || s < -(1LL << (order - 1))) {
 			if (MoreTape() == false)
 				return false;
 		}
 		head = s;
-		if (head <= std::numeric_limits<long long>::max() && head >= std::numeric_limits<long long>::min())
-			return true;
-		else 
-			return false;
+		return true;
 	}
-	void NewTape(unsigned char n) {
-		Tape = MakeTape(n);
-		//zero = Tape.size() / 2;
-		order = n;
+	// Scans. A program looking for the next 1 or the end of a block with right and read evaluates one instruction per cell;
+	// these look at the whole tape in one instruction. Tapes of one-byte cells are scanned with memchr and eight cells to a word, others cell by cell.
+	// The cells off the tape are blank, so seeking or counting the blank symbol accounts for them.
+
+	using Cell = typename Medium<V>::value_type;
+	static constexpr bool Bytewise = sizeof(Cell) == 1 && std::is_trivially_copyable_v<Cell> && std::endian::native == std::endian::little;
+
+	static Cell CellOf(const V& symbol) {
+		if constexpr (requires { typename V::inner_type; }) return symbol.value;
+		else return symbol;
 	}
 
-	bool MoreTape() {
-		//if (order + 1 >= (sizeof(unsigned char) * 8)) { // max order = 255 for unsigned char
-		if (order + 1 >= 64) { // max order = 63 for unsigned long long, which is the largest we can use for indexing the tape
-			std::cerr << "Max tape order reached\n";
-			return false;
+	// The high bit of every byte of x that is zero, and no other bit.
+	static std::uint64_t ZeroBytes(std::uint64_t x) {
+		constexpr std::uint64_t low = 0x7F7F7F7F7F7F7F7FULL;
+		return ~(((x & low) + low) | x | low);
+	}
+
+	static std::uint64_t Word(const Cell* cells) {
+		std::uint64_t w;
+		std::memcpy(&w, cells, 8);
+		return w;
+	}
+
+	// The first cell in [from, to) holding symbol, or to.
+	static std::size_t ScanForward(const Cell* cells, std::size_t from, std::size_t to, Cell symbol) {
+		if (from >= to) return to;
+		if constexpr (Bytewise) {
+			unsigned char byte;
+			std::memcpy(&byte, &symbol, 1);
+			const void* found = std::memchr(cells + from, byte, to - from);
+			return found ? static_cast<std::size_t>(static_cast<const Cell*>(found) - cells) : to;
 		}
-		std::size_t oldSize = Tape.size();
-		std::size_t newSize = oldSize * 2;
-		Medium<V> VTape = MakeTape(order + 1); // makes newSize
-		std::size_t oldZero = oldSize / 2;
-		std::size_t newZero = newSize / 2;
-		for (std::size_t i = 0; i < oldSize; ++i) {
-			VTape[i + newZero - oldZero] = Tape[i];
+		else {
+			return static_cast<std::size_t>(std::find(cells + from, cells + to, symbol) - cells);
 		}
-		Tape = std::move(VTape);
-		++order;
-		return true;
 	}
 
-	void Shrink() {
-		long long zero = 1LL << (order - 1);
-		long long minIndex = static_cast<long long>(Tape.size()) - 1;
-		long long maxIndex = -1;
-
-		// Find the bounds of non-default values
-		for (long long i = 0, n = static_cast<long long>(Tape.size()); i < n; ++i) {
-			V val;
-			if constexpr (requires { typename V::inner_type; }) {
-				val = V(Tape[i]);
-			}
-			else {
-				val = Tape[i];
-			}
-			if (!(val == V{})) {
-				minIndex = std::min(minIndex, i);
-				maxIndex = std::max(maxIndex, i);
+	// The last cell in [from, to) holding symbol, or to.
+	static std::size_t ScanBackward(const Cell* cells, std::size_t from, std::size_t to, Cell symbol) {
+		std::size_t i = to;
+		if constexpr (Bytewise) {
+			unsigned char byte;
+			std::memcpy(&byte, &symbol, 1);
+			const std::uint64_t pattern = 0x0101010101010101ULL * byte;
+			while (i >= from + 8) {
+				std::uint64_t zeros = ZeroBytes(Word(cells + i - 8) ^ pattern);
+				if (zeros != 0) return i - 8 + static_cast<std::size_t>(63 - std::countl_zero(zeros)) / 8;
+				i -= 8;
 			}
 		}
-
-		// If no non-default values found, reset to minimal tape
-		if (maxIndex < minIndex) {
-			NewTape(1);
-			head = 0;
-			return;
+		while (i > from) {
+			if (cells[--i] == symbol) return i;
 		}
+		return to;
+	}
 
-		long long newSize = maxIndex - minIndex + 1;
-		unsigned char newOrder = static_cast<unsigned>(std::ceil(std::log2(static_cast<double>(newSize))));
-		Medium<V> newTape = MakeTape(newOrder);
-		long long newZero = 1LL << (newOrder - 1);
-
-		for (long long i = minIndex; i <= maxIndex; ++i) {
-			newTape[i - minIndex + newZero] = Tape[i];
+	// The cells in [from, to) holding symbol.
+	static std::size_t CountCells(const Cell* cells, std::size_t from, std::size_t to, Cell symbol) {
+		std::size_t n = 0, i = from;
+		if constexpr (Bytewise) {
+			unsigned char byte;
+			std::memcpy(&byte, &symbol, 1);
+			const std::uint64_t pattern = 0x0101010101010101ULL * byte;
+			// Each byte of sum counts the matches in its lane, folded into n before a lane can pass 255.
+			while (i + 8 <= to) {
+				std::uint64_t sum = 0;
+				for (std::size_t k = 0; k < 255 && i + 8 <= to; ++k, i += 8) sum += ZeroBytes(Word(cells + i) ^ pattern) >> 7;
+				sum = (sum & 0x00FF00FF00FF00FFULL) + ((sum >> 8) & 0x00FF00FF00FF00FFULL); // four 16 bit lanes
+				n += static_cast<std::size_t>((sum * 0x0001000100010001ULL) >> 48);
+			}
 		}
+		for (; i < to; ++i) n += cells[i] == symbol;
+		return n;
+	}
 
-		head = head - minIndex;
-		Tape = std::move(newTape);
-		order = newOrder;
+	// The scans of this tape: packed and columnar tapes scan themselves, the others are contiguous cells.
+	std::size_t Next(std::size_t from, std::size_t to, Cell symbol) const {
+		if constexpr (SelfScanning<Medium<V>>) return Tape.Next(from, to, symbol);
+		else return ScanForward(&Tape[0], from, to, symbol);
 	}
-	
-};
 
-// Character Set operations
-auto Intersection (std::set<unsigned char>A, std::set<unsigned char>B, std::set<unsigned char>Dest){
-	return std::set_intersection(A.begin(), A.end(),
-							B.begin(), B.end(),
-							std::inserter(Dest, Dest.begin()));
-}
-auto Union (std::set<unsigned char>A, std::set<unsigned char>B, std::set<unsigned char>Dest){
-	return std::set_union(A.begin(), A.end(),
-							B.begin(), B.end(),
-							std::inserter(Dest, Dest.begin()));
-}
-auto Difference (std::set<unsigned char>A, std::set<unsigned char>B, std::set<unsigned char>Dest){
-	return std::set_difference(A.begin(), A.end(),
-							B.begin(), B.end(),
-							std::inserter(Dest, Dest.begin()));
-}
-bool Inclusion (std::set<unsigned char>A, std::set<unsigned char>B){
-	return std::includes(A.begin(), A.end(),
-							B.begin(), B.end());
-}
+	std::size_t Previous(std::size_t from, std::size_t to, Cell symbol) const {
+		if constexpr (SelfScanning<Medium<V>>) return Tape.Previous(from, to, symbol);
+		else return ScanBackward(&Tape[0], from, to, symbol);
+	}
 
+	std::size_t CountOf(std::size_t from, std::size_t to, Cell symbol) const {
+		if constexpr (SelfScanning<Medium<V>>) return Tape.Count(from, to, symbol);
+		else return CountCells(&Tape[0], from, to, symbol);
+	}
 
-// Here, we define Abstract Machine to use a language over char8_t
-// but we could easily refactor to any Value V.
-//template <Value V>
-class AbstractMachine {
-public:
-	// friend class States;
-	Language<char8_t> language;
-    std::vector<std::unique_ptr<Resource>> Resources;
+	// Moves the head to the nearest cell holding symbol, to the right of the head when direction is positive and to the left otherwise.
+	// When no such cell is found the head stays put and Seek returns false.
+	bool Seek(const V& symbol, long long direction = 1) {
+		const Cell cell = CellOf(symbol);
+		const long long zero = static_cast<long long>(Tape.size()) / 2;
+		const std::size_t at = static_cast<std::size_t>(head + zero);
+		std::size_t found = direction > 0 ? Next(at + 1, Tape.size(), cell) : Previous(0, at, cell);
+		if (found != (direction > 0 ? Tape.size() : at)) {
+			head = static_cast<long long>(found) - zero;
+			return true;
+		}
+		if (cell == Cell{}) return GoTo(direction > 0 ? zero : -zero - 1); // the first cell off the tape
+		return false;
+	}
 
-	std::vector<Token<char8_t>> ResourceRegistry;
+	// The number of cells from first to last, both included, holding symbol.
+	unsigned long long Count(const V& symbol, long long first, long long last) {
+		if (first > last) return 0;
+		const Cell cell = CellOf(symbol);
+		const long long zero = static_cast<long long>(Tape.size()) / 2;
+		long long from = std::max(first, -zero), to = std::min(last, zero - 1);
+		unsigned long long n = from <= to ? CountOf(static_cast<std::size_t>(from + zero), static_cast<std::size_t>(to + zero + 1), cell) : 0;
+		if (cell == Cell{}) n += static_cast<unsigned long long>(last - first + 1) - (from <= to ? static_cast<unsigned long long>(to - from + 1) : 0);
+		return n;
+	}
 
-	Substrate<bool>* Tape;
-	States* StateRegister;
-	
-	std::set<Medium<char8_t>> RunComms = { u8"run", u8"rn"};
-	std::set<Medium<char8_t>> TapeComms = { u8"tape", u8"te"};
-	std::set<Medium<char8_t>> StateComms = { u8"state", u8"se"};
+	// The number of cells on the tape holding symbol.
+	unsigned long long Count(const V& symbol) {
+		const long long zero = static_cast<long long>(Tape.size()) / 2;
+		return Count(symbol, -zero, zero - 1);
+	}
+
+	// Moves the head to the first cell of the nearest occurrence of pattern, to the right of the head when direction is positive and to the left otherwise.
+	bool Find(const std::vector<V>& pattern, long long direction = 1) {
+		if (pattern.empty() || pattern.size() > Tape.size()) return false;
+		const Medium<V>& cells = Tape;
+		const long long zero = static_cast<long long>(Tape.size()) / 2;
+		const std::size_t at = static_cast<std::size_t>(head + zero);
+		const std::size_t last = Tape.size() - pattern.size(); // the last cell an occurrence can start at
+
+		// Scan for the first symbol of the pattern that is not blank, since most of a tape is, and check the rest around it.
+		std::size_t anchor = 0;
+		while (anchor + 1 < pattern.size() && CellOf(pattern[anchor]) == Cell{}) ++anchor;
+		const Cell symbol = CellOf(pattern[anchor]);
+		auto matches = [&](std::size_t start) {
+			for (std::size_t k = 0; k < pattern.size(); ++k) {
+				if (!(cells[start + k] == CellOf(pattern[k]))) return false;
+			}
+			return true;
+		};
+
+		std::size_t found = Tape.size();
+		if (direction > 0) {
+			for (std::size_t start = at + 1; start <= last; ++start) {
+				std::size_t i = Next(start + anchor, last + anchor + 1, symbol);
+				if (i > last + anchor) break;
+				start = i - anchor;
+				if (matches(start)) {
+					found = start;
+					break;
+				}
+			}
+		}
+		else {
+			for (std::size_t end = std::min(at, last + 1); end > 0; ) { // occurrences starting before end
+				std::size_t i = Previous(anchor, end + anchor, symbol);
+				if (i == end + anchor) break;
+				end = i - anchor;
+				if (matches(end)) {
+					found = end;
+					break;
+				}
+			}
+		}
+		if (found == Tape.size()) return false;
+		head = static_cast<long long>(found) - zero;
+		return true;
+	}
+
+	// A symbol written as text, as write reads it.
+	std::optional<V> Parse(const Medium<char8_t>& word) {
+		return ParseValue<V>(word);
+	}
+
+	static std::optional<long long> Integer(const Medium<char8_t>& word) {
+		long long value = 0;
+		const char* first = reinterpret_cast<const char*>(word.data());
+		auto [ptr, ec] = std::from_chars(first, first + word.size(), value);
+		if (word.empty() || ec != std::errc{} || ptr != first + word.size()) return std::nullopt;
+		return value;
+	}
+
+	// "left" or "lt" scans to the left, anything else to the right.
+	long long Direction(const Medium<char8_t>& word) {
+		return leftcomms.contains(std::get<Medium<char8_t>>(ToLower(word))) ? -1 : 1;
+	}
+
+	// seek SYMBOL [left|right]
+	std::any SeekSemantic(const Medium<char8_t>& prog) {
+		std::size_t pos = 0;
+		language.Bite(prog, pos); // Skip "seek" command
+		std::optional<V> symbol = Parse(language.Bite(prog, pos));
+		if (!symbol) return std::any{};
+		return Seek(*symbol, Direction(language.Bite(prog, pos)));
+	}
+
+	// count SYMBOL [FIRST LAST]: the whole tape without a range.
+	std::any CountSemantic(const Medium<char8_t>& prog) {
+		std::size_t pos = 0;
+		language.Bite(prog, pos); // Skip "count" command
+		std::optional<V> symbol = Parse(language.Bite(prog, pos));
+		if (!symbol) return std::any{};
+		if (pos == prog.size()) return Count(*symbol);
+		std::optional<long long> first = Integer(language.Bite(prog, pos));
+		std::optional<long long> last = Integer(language.Bite(prog, pos));
+		if (!first || !last) return std::any{};
+		return Count(*symbol, *first, *last);
+	}
+
+	// find PATTERN [left|right]. On tapes of bool or characters the pattern is one word, a symbol per character, as in "find 0110";
+	// on other tapes it is one word per symbol, and a direction may only follow a pattern of characters.
+	std::any FindSemantic(const Medium<char8_t>& prog) {
+		std::size_t pos = 0;
+		language.Bite(prog, pos); // Skip "find" command
+		std::vector<V> pattern;
+		long long direction = 1;
+		if constexpr (std::is_same_v<V, bool> || Char<V>) {
+			for (char8_t c : language.Bite(prog, pos)) {
+				std::optional<V> symbol = Parse(Medium<char8_t>(1, c));
+				if (!symbol) return std::any{};
+				pattern.push_back(*symbol);
+			}
+			direction = Direction(language.Bite(prog, pos));
+		}
+		else {
+			while (pos < prog.size()) {
+				std::optional<V> symbol = Parse(language.Bite(prog, pos));
+				if (!symbol) return std::any{};
+				pattern.push_back(*symbol);
+			}
+		}
+		return Find(pattern, direction);
+	}
+
+	// Range operations, for tapes of numbers. A numerical machine updating a block of cells one right and write at a time does it here in one instruction.
+	// Ranges are the cells from first to last, both included. The loops run over the contiguous valarray and are left to the compiler to vectorize;
+	// with threads above 1, a range is split among up to that many threads, each piece ParallelCells or more.
+
+	static constexpr bool Numeric = Arithmetic<V> && !Char<V> && !std::is_same_v<V, bool>; // the tapes that are valarrays of numbers
+
+	enum class Operation { Add, Multiply, And, Or };
+
+	// What a sum adds up in: wide enough that a sum of small cells does not wrap.
+	using Total = typename std::conditional_t<std::is_floating_point_v<V>, std::common_type<V, double>,
+		std::conditional<std::is_signed_v<V>, long long, unsigned long long>>::type;
+
+	// Every range operation starts its threads afresh, at some tens of microseconds each. A million cells take long enough that this is a few percent of the work;
+	// 65536 took about as long as starting a thread.
+	static constexpr std::size_t ParallelCells = std::size_t(1) << 20;
+	unsigned threads = 1;
+
+	// Grows the tape until it holds the cells from first to last.
+	bool Reach(long long first, long long last) {
+		while (first < -(1LL << (order - 1)) || last >= (1LL << (order - 1))) {
+			if (MoreTape() == false)
+				return false;
+		}
+		return true;
+	}
+
+	// The pieces a range of n cells is split into: one per thread, or one when the range is too small to be worth it.
+	std::size_t Pieces(std::size_t n) const {
+		return std::max<std::size_t>(1, std::min<std::size_t>(threads, n / ParallelCells));
+	}
+
+	// Calls f(piece, begin, end) for every piece of the cells [from, to), the first on this thread and the rest on threads of their own.
+	template <typename F>
+	static void Parallel(std::size_t from, std::size_t to, std::size_t pieces, F f) {
+		auto piece = [&](std::size_t i) { f(i, from + (to - from) * i / pieces, from + (to - from) * (i + 1) / pieces); };
+		if (pieces == 1) return piece(0);
+		std::vector<std::thread> workers;
+		for (std::size_t i = 1; i < pieces; ++i) workers.emplace_back(piece, i);
+		piece(0);
+		for (std::thread& worker : workers) worker.join();
+	}
+
+	template <typename F>
+	static bool WithOperation(Operation op, F f) {
+		switch (op) {
+		case Operation::Add: f(std::plus<>{}); return true;
+		case Operation::Multiply: f(std::multiplies<>{}); return true;
+		case Operation::And:
+			if constexpr (std::integral<V>) { f(std::bit_and<>{}); return true; }
+			else return false;
+		case Operation::Or:
+			if constexpr (std::integral<V>) { f(std::bit_or<>{}); return true; }
+			else return false;
+		}
+		return false;
+	}
+
+	// Combines every cell from first to last with value.
+	bool Apply(Operation op, const V& value, long long first, long long last) requires Numeric {
+		if (first > last || !Reach(first, last)) return false;
+		const long long zero = static_cast<long long>(Tape.size()) / 2;
+		const std::size_t from = static_cast<std::size_t>(first + zero), to = static_cast<std::size_t>(last + zero + 1);
+		const V operand = value; // a copy, so the compiler knows writing the cells does not change it
+		V* cells = &Tape[0];
+		if (hashing) hash ^= Keys(first, last);
+		bool done = WithOperation(op, [&](auto f) {
+			Parallel(from, to, Pieces(to - from), [&](std::size_t, std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; ++i) cells[i] = static_cast<V>(f(cells[i], operand));
+			});
+		});
+		if (hashing) hash ^= Keys(first, last);
+		return done;
+	}
+
+	// Combines every cell from first to last with the cell as far from source as it is from first.
+	bool Combine(Operation op, long long source, long long first, long long last) requires Numeric {
+		if (first > last || !Reach(first, last) || !Reach(source, source + (last - first))) return false;
+		const long long zero = static_cast<long long>(Tape.size()) / 2;
+		const std::size_t from = static_cast<std::size_t>(first + zero), to = static_cast<std::size_t>(last + zero + 1);
+		V* cells = &Tape[0];
+		const V* operands = cells + (source + zero);
+		std::valarray<V> copy;
+		if (source != first && source <= last && first <= source + (last - first)) { // overlapping ranges read the cells as they were
+			copy = std::valarray<V>(Tape[std::slice(static_cast<std::size_t>(source + zero), to - from, 1)]);
+			operands = &copy[0];
+		}
+		if (hashing) hash ^= Keys(first, last);
+		bool done = WithOperation(op, [&](auto f) {
+			Parallel(from, to, Pieces(to - from), [&](std::size_t, std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; ++i) cells[i] = static_cast<V>(f(cells[i], operands[i - from]));
+			});
+		});
+		if (hashing) hash ^= Keys(first, last);
+		return done;
+	}
+
+	// Replaces every cell from first to last by the sum of the cells from first up to it.
+	bool Scan(long long first, long long last) requires Numeric {
+		if (first > last || !Reach(first, last)) return false;
+		const long long zero = static_cast<long long>(Tape.size()) / 2;
+		const std::size_t from = static_cast<std::size_t>(first + zero), to = static_cast<std::size_t>(last + zero + 1);
+		const std::size_t pieces = Pieces(to - from);
+		V* cells = &Tape[0];
+		if (hashing) hash ^= Keys(first, last);
+		if (pieces == 1) {
+			V running{};
+			for (std::size_t i = from; i < to; ++i) cells[i] = running = static_cast<V>(running + cells[i]);
+			if (hashing) hash ^= Keys(first, last);
+			return true;
+		}
+		// Each piece sums itself, then adds the total of the pieces before it.
+		std::vector<V> before(pieces + 1, V{});
+		Parallel(from, to, pieces, [&](std::size_t p, std::size_t begin, std::size_t end) {
+			V running{};
+			for (std::size_t i = begin; i < end; ++i) cells[i] = running = static_cast<V>(running + cells[i]);
+			before[p + 1] = running;
+		});
+		for (std::size_t p = 1; p <= pieces; ++p) before[p] = static_cast<V>(before[p - 1] + before[p]);
+		Parallel(from, to, pieces, [&](std::size_t p, std::size_t begin, std::size_t end) {
+			const V offset = before[p];
+			for (std::size_t i = begin; i < end; ++i) cells[i] = static_cast<V>(cells[i] + offset);
+		});
+		if (hashing) hash ^= Keys(first, last);
+		return true;
+	}
+
+	// Reduces the cells from first to last that are on the tape, piece by piece, and folds the pieces with fold.
+	// Returns whether any cell was off the tape, since those are blank.
+	template <typename R, typename Cells, typename Fold>
+	bool Reduce(long long first, long long last, R& result, Cells cellsof, Fold fold) {
+		const long long zero = static_cast<long long>(Tape.size()) / 2;
+		long long from = std::max(first, -zero), to = std::min(last, zero - 1);
+		if (from <= to) {
+			const std::size_t begin = static_cast<std::size_t>(from + zero), end = static_cast<std::size_t>(to + zero + 1);
+			const std::size_t pieces = Pieces(end - begin);
+			const V* cells = &Tape[0];
+			if (pieces == 1) result = cellsof(cells, begin, end, result);
+			else {
+				std::vector<R> partial(pieces, result);
+				Parallel(begin, end, pieces, [&](std::size_t p, std::size_t b, std::size_t e) { partial[p] = cellsof(cells, b, e, partial[p]); });
+				for (const R& r : partial) result = fold(result, r);
+			}
+		}
+		return from > first || to < last;
+	}
+
+	Total Sum(long long first, long long last) requires Numeric {
+		Total sum{};
+		if (first > last) return sum;
+		Reduce(first, last, sum, [](const V* cells, std::size_t from, std::size_t to, Total s) {
+			for (std::size_t i = from; i < to; ++i) s += cells[i];
+			return s;
+		}, std::plus<>{});
+		return sum;
+	}
+
+	V Min(long long first, long long last) requires Numeric {
+		if (first > last) throw std::invalid_argument("Empty range\n");
+		V least = std::numeric_limits<V>::max();
+		bool blanks = Reduce(first, last, least, [](const V* cells, std::size_t from, std::size_t to, V m) {
+			for (std::size_t i = from; i < to; ++i) m = std::min(m, cells[i]);
+			return m;
+		}, [](V a, V b) { return std::min(a, b); });
+		return blanks ? std::min(least, V{}) : least;
+	}
+
+	V Max(long long first, long long last) requires Numeric {
+		if (first > last) throw std::invalid_argument("Empty range\n");
+		V most = std::numeric_limits<V>::lowest();
+		bool blanks = Reduce(first, last, most, [](const V* cells, std::size_t from, std::size_t to, V m) {
+			for (std::size_t i = from; i < to; ++i) m = std::max(m, cells[i]);
+			return m;
+		}, [](V a, V b) { return std::max(a, b); });
+		return blanks ? std::max(most, V{}) : most;
+	}
+
+	// The range FIRST LAST at pos, or the whole tape when the instruction ends there.
+	std::optional<std::pair<long long, long long>> Range(const Medium<char8_t>& prog, std::size_t& pos) {
+		if (pos == prog.size()) {
+			const long long zero = static_cast<long long>(Tape.size()) / 2;
+			return std::make_pair(-zero, zero - 1);
+		}
+		std::optional<long long> first = Integer(language.Bite(prog, pos));
+		std::optional<long long> last = Integer(language.Bite(prog, pos));
+		if (!first || !last || *first > *last) return std::nullopt;
+		return std::make_pair(*first, *last);
+	}
+
+	// add VALUE [FIRST LAST], or add @SOURCE [FIRST LAST] to add the range starting at cell SOURCE. Likewise multiply, and, or.
+	std::any MapSemantic(Operation op, const Medium<char8_t>& prog) requires Numeric {
+		std::size_t pos = 0;
+		language.Bite(prog, pos); // Skip the command
+		Medium<char8_t> operand = language.Bite(prog, pos);
+		auto range = Range(prog, pos);
+		if (!range || operand.empty()) return std::any{};
+		if (operand[0] == u8'@') {
+			std::optional<long long> source = Integer(operand.substr(1));
+			if (!source) return std::any{};
+			return Combine(op, *source, range->first, range->second);
+		}
+		std::optional<V> value = Parse(operand);
+		if (!value) return std::any{};
+		return Apply(op, *value, range->first, range->second);
+	}
+
+	// scan, sum, min or max [FIRST LAST]
+	std::any ReduceSemantic(const Medium<char8_t>& name, const Medium<char8_t>& prog) requires Numeric {
+		std::size_t pos = 0;
+		language.Bite(prog, pos); // Skip the command
+		auto range = Range(prog, pos);
+		if (!range) return std::any{};
+		if (name == u8"scan") return Scan(range->first, range->second);
+		if (name == u8"sum") return Sum(range->first, range->second);
+		if (name == u8"min") return Min(range->first, range->second);
+		return Max(range->first, range->second);
+	}
+
+	void NewTape(unsigned char n) {
+		Tape = MakeTape(n);
+		hash = 0;
+		//zero = Tape.size() / 2;
+		order = n;
+	}
+
+	bool MoreTape() {
+		//if (order + 1 >= (sizeof(unsigned char) * 8)) { // max order = 255 for unsigned char
+		if (order + 1 >= 64) { // max order = 63 for unsigned long long, which is the largest we can use for indexing the tape
+			std::cerr << "Max tape order reached\n";
+			return false;
+		}
+		if (stats != nullptr) {
+			++stats->growths;
+			stats->copied += Bytes(Tape.size());
+		}
+		std::size_t oldSize = Tape.size();
+		std::size_t newSize = oldSize * 2;
+		Medium<V> VTape = MakeTape(order + 1); // makes newSize
+		std::size_t oldZero = oldSize / 2;
+		std::size_t newZero = newSize / 2;
+		CopyCells(VTape, newZero - oldZero, Tape, 0, oldSize);
+		Tape = std::move(VTape);
+		++order;
+		return true;
+	}
+
+	// Shrink drops the blank ends of the tape. Cells keep their positions, so the head and every written cell stay where they were.
+	void Shrink() {
+		long long zero = 1LL << (order - 1);
+		// The head's cell is always kept
+		long long minCell = head;
+		long long maxCell = head;
+
+		// Find the bounds of non-default values
+		if constexpr (requires { Tape.Occupied(V{}); }) {
+			auto [lowest, highest] = Tape.Occupied(V{});
+			if (lowest <= highest) {
+				minCell = std::min(minCell, static_cast<long long>(lowest) - zero);
+				maxCell = std::max(maxCell, static_cast<long long>(highest) - zero);
+			}
+		}
+		else for (long long i = 0, n = static_cast<long long>(Tape.size()); i < n; ++i) {
+			V val;
+			if constexpr (requires { typename V::inner_type; }) {
+				val = V(Tape[i]);
+			}
+			else {
+				val = Tape[i];
+			}
+			if (!(val == V{})) {
+				minCell = std::min(minCell, i - zero);
+				maxCell = std::max(maxCell, i - zero);
+			}
+		}
+
+		// the smallest order whose tape holds [minCell, maxCell]
+		unsigned char newOrder = 1;
+		while (maxCell >= (1LL << (newOrder - 1)) || minCell < -(1LL << (newOrder - 1))) {
+			++newOrder;
+		}
+		if (newOrder >= order) return;
+
+		Medium<V> newTape = MakeTape(newOrder);
+		long long newZero = 1LL << (newOrder - 1);
+		long long first = std::max(minCell, -zero);
+		long long last = std::min(maxCell, zero - 1);
+
+		if (first <= last) CopyCells(newTape, static_cast<std::size_t>(first + newZero), Tape, static_cast<std::size_t>(first + zero), static_cast<std::size_t>(last - first + 1));
+
+		if (stats != nullptr) {
+			++stats->shrinks;
+			stats->copied += Bytes(static_cast<std::size_t>(last - first + 1));
+		}
+
+		Tape = std::move(newTape);
+		order = newOrder;
+	}
+	
+};
+
+// A Result is what a single instruction leaves behind: the concept that recognized it, the value its semantic returned and how much of the program it consumed.
+using Result = std::tuple<Token<char8_t>, std::any, unsigned long long>;
+
+// A ResultSink receives the Result of every instruction the machine evaluates, as soon as it is evaluated.
+// Run streams into a sink instead of accumulating vectors, so the sink decides what (if anything) is kept.
+class ResultSink {
+public:
+	virtual ~ResultSink() = default;
+	virtual void Push(const Token<char8_t>& name, std::any&& value, unsigned long long consumed) = 0;
+
+	// Whether the sink looks at the results at all. Macro steps replay instructions without producing their results, so they only run for a sink that does not.
+	virtual bool Keeps() const { return true; }
+};
+
+// Drops every result. This is the machine's default sink.
+class DiscardSink : public ResultSink {
+public:
+	void Push(const Token<char8_t>&, std::any&&, unsigned long long) override {}
+	bool Keeps() const override { return false; }
+};
+
+// Keeps only how many instructions were evaluated and how many characters they consumed.
+class CountSink : public ResultSink {
+public:
+	unsigned long long count = 0;
+	unsigned long long consumed = 0;
+
+	void Push(const Token<char8_t>&, std::any&&, unsigned long long length) override {
+		++count;
+		consumed += length;
+	}
+};
+
+// Keeps the most recent result only.
+class LastResultSink : public ResultSink {
+public:
+	std::optional<Result> last;
+
+	void Push(const Token<char8_t>& name, std::any&& value, unsigned long long consumed) override {
+		last.emplace(name, std::move(value), consumed);
+	}
+};
+
+// Keeps the last n results in a fixed ring. Results() returns them oldest first.
+class RingBufferSink : public ResultSink {
+public:
+	std::vector<Result> ring;
+	std::size_t next = 0;
+	unsigned long long pushed = 0;
+
+	RingBufferSink(std::size_t n) : ring(n) {
+		if (n == 0) throw std::invalid_argument("Ring buffer needs room for at least one result\n");
+	}
+
+	void Push(const Token<char8_t>& name, std::any&& value, unsigned long long consumed) override {
+		ring[next] = std::make_tuple(name, std::move(value), consumed);
+		next = (next + 1) % ring.size();
+		++pushed;
+	}
+
+	std::vector<Result> Results() const {
+		std::vector<Result> results;
+		std::size_t n = static_cast<std::size_t>(std::min<unsigned long long>(pushed, ring.size()));
+		std::size_t first = (next + ring.size() - n) % ring.size();
+		for (std::size_t i = 0; i < n; ++i) {
+			results.push_back(ring[(first + i) % ring.size()]);
+		}
+		return results;
+	}
+};
+
+// Hands every result to a user function.
+class CallbackSink : public ResultSink {
+public:
+	std::function<void(const Token<char8_t>&, std::any&&, unsigned long long)> f;
+
+	CallbackSink(std::function<void(const Token<char8_t>&, std::any&&, unsigned long long)> callback) : f(std::move(callback)) {}
+
+	void Push(const Token<char8_t>& name, std::any&& value, unsigned long long consumed) override {
+		f(name, std::move(value), consumed);
+	}
+};
+
+// Materializes every result, in evaluation order. This is what Run used to return.
+class CollectSink : public ResultSink {
+public:
+	std::vector<Result> results;
+
+	void Push(const Token<char8_t>& name, std::any&& value, unsigned long long consumed) override {
+		results.emplace_back(name, std::move(value), consumed);
+	}
+};
+
+
+// A TokenArena lends out the scratch tokens the machine builds for the instruction being evaluated.
+// Tokens are lent and returned in stack order, one set per step, and keep their buffers when returned, so once the arena has grown to the deepest call, a step allocates nothing for them.
+class TokenArena {
+public:
+	class Lease {
+	public:
+		Lease(TokenArena& a, Token<char8_t>& t) : arena(&a), token(&t) {}
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+		~Lease() { --arena->used; }
+
+		const Token<char8_t>& operator*() const { return *token; }
+		const Medium<char8_t>& Text() const { return std::get<Medium<char8_t>>(*token); }
+
+	private:
+		TokenArena* arena;
+		Token<char8_t>* token;
+	};
+
+	// A scratch token holding the text from begin to end, until the lease goes out of scope.
+	Lease Acquire(Medium<char8_t>::const_iterator begin, Medium<char8_t>::const_iterator end) {
+		if (used == tokens.size()) {
+			tokens.push_back(std::make_unique<Token<char8_t>>(Medium<char8_t>{}));
+			if (stats != nullptr) stats->Allocation();
+		}
+		Token<char8_t>& token = *tokens[used++];
+		std::get<Medium<char8_t>>(token).assign(begin, end);
+		return Lease(*this, token);
+	}
+
+	std::size_t Size() const { return tokens.size(); }
+
+	Statistics* stats = nullptr; // set by the machine that owns this arena
+
+private:
+	std::vector<std::unique_ptr<Token<char8_t>>> tokens; // behind pointers, so a lent token stays put when the arena grows
+	std::size_t used = 0;
+};
+
+// MacroSteps remembers what the program of a state did to the tape, so that when the machine enters the state again with the same cells around the head
+// it can replay the outcome instead of evaluating the instructions. A macro step runs from a jump into a state to the next jump made at the same level,
+// and covers the cells it read or wrote, relative to the head it started on. Its outcome depends on those cells and nothing else,
+// so a replay leaves the tape, the head and the state exactly as evaluation would, wherever on the tape it happens.
+// A machine sweeping a block or going round a loop of states that moves along the tape replays the same few steps over and over.
+// Only steps made of local tape commands and control flow are kept: a goto, a scan, a range operation or another resource makes the outcome depend on more than the cells.
+template <Value V>
+class MacroSteps {
+public:
+	// What an instruction does to the tape, as far as a macro step is concerned.
+	enum class Effect : unsigned char { Local, Reads, Writes, Foreign };
+
+	struct Step {
+		long long low, high; // the cells covered, relative to the head on entry
+		std::vector<V> before, after; // their symbols on entry and on leaving
+		long long move; // where the head is left, relative to where it was
+		unsigned long long next; // the state jumped to at the end
+		unsigned long long instructions; // the instructions evaluated the time it was recorded
+	};
+
+	static constexpr std::size_t Limit = 16; // steps kept per state
+	static constexpr long long Window = 256; // the most cells a step can cover
+
+	bool on = false;
+	std::unordered_map<unsigned long long, std::vector<Step>> steps;
+	unsigned long long edits = 0; // the edits of the state table the steps were recorded under
+
+	unsigned depth = 0; // how many Runs are under way
+
+	static Effect EffectOf(std::int32_t resource, const Medium<char8_t>& name, bool literal) {
+		if (resource < 0) {
+			if (name == u8"branch") return Effect::Reads;
+			if (literal || name == u8"jump" || name == u8"call" || name == u8"nothing") return Effect::Local;
+		}
+		else if (resource == 0) { // the tape
+			if (name == u8"read") return Effect::Reads;
+			if (name == u8"write") return Effect::Writes;
+			if (name == u8"left" || name == u8"right" || name == u8"move" || name == u8"head" || name == u8"shrink") return Effect::Local;
+		}
+		return Effect::Foreign;
+	}
+
+	void Begin(unsigned long long st, long long head, unsigned long long evaluated) {
+		recording = true;
+		local = true;
+		level = depth;
+		state = st;
+		start = head;
+		low = 0;
+		high = -1;
+		instructions = evaluated;
+		written.clear();
+	}
+
+	// Called before an instruction with the given effect is evaluated with the head at cell.
+	void Observe(Effect effect, Substrate<V>& tape) {
+		if (effect == Effect::Foreign) local = false;
+		if (effect == Effect::Local || !local) return;
+		long long cell = tape.head - start;
+		if (low > high) low = high = cell;
+		else {
+			low = std::min(low, cell);
+			high = std::max(high, cell);
+		}
+		if (effect == Effect::Writes) written.emplace_back(cell, tape.At(tape.head));
+	}
+
+	// Ends the step being recorded with a jump to next, and keeps it if it is one that can be replayed.
+	void End(Substrate<V>& tape, unsigned long long next, unsigned long long evaluated) {
+		recording = false;
+		if (!local || high - low >= Window) return;
+		std::vector<Step>& kept = steps[state];
+		if (kept.size() >= Limit) return;
+		Step step{ low, high, {}, {}, tape.head - start, next, evaluated - instructions };
+		for (long long c = low; c <= high; ++c) step.after.push_back(tape.At(start + c));
+		step.before = step.after;
+		// the first write to a cell saw the symbol it held on entry
+		for (auto w = written.rbegin(); w != written.rend(); ++w) step.before[static_cast<std::size_t>(w->first - low)] = w->second;
+		kept.push_back(std::move(step));
+	}
+
+	// Drops the step being recorded when the Run at its level finishes without jumping.
+	void Leave() {
+		if (recording && level == depth) recording = false;
+		--depth;
+	}
+
+	bool Recording() const { return recording; }
+	void Drop() { recording = false; } // gives up the step being recorded, as when the run making it is suspended
+	bool Outer() const { return !recording || level == depth; } // a jump inside a called state belongs to its caller's step
+
+	// A kept step of st that starts from the cells around the head, if there is one.
+	const Step* Match(Substrate<V>& tape, unsigned long long st) {
+		auto found = steps.find(st);
+		if (found == steps.end()) return nullptr;
+		for (const Step& step : found->second) {
+			bool same = true;
+			for (long long c = step.low; same && c <= step.high; ++c) same = tape.At(tape.head + c) == step.before[static_cast<std::size_t>(c - step.low)];
+			if (same) return &step;
+		}
+		return nullptr;
+	}
+
+	static void Apply(Substrate<V>& tape, const Step& step) {
+		for (long long c = step.low; c <= step.high; ++c) {
+			std::size_t i = static_cast<std::size_t>(c - step.low);
+			if (!(step.after[i] == step.before[i])) tape.Put(tape.head + c, step.after[i]);
+		}
+		tape.Move(step.move);
+	}
+
+	void Clear() {
+		steps.clear();
+		recording = false;
+	}
+
+	// Keeps depth for the length of a Run.
+	struct Level {
+		MacroSteps& macros;
+		explicit Level(MacroSteps& m) : macros(m) { ++macros.depth; }
+		~Level() { macros.Leave(); }
+	};
+
+private:
+	bool recording = false;
+	bool local = true;
+	unsigned level = 0; // the Run the step being recorded belongs to
+	unsigned long long state = 0;
+	long long start = 0; // the head on entry
+	long long low = 0, high = -1;
+	unsigned long long instructions = 0; // instructions evaluated before the step began
+	std::vector<std::pair<long long, V>> written; // the symbol each write overwrote, relative to start
+};
+
+class ProgramImage; // see ProgramImage.h
+
+// Here, we define Abstract Machine to use a language over char8_t, with a tape of symbols of type V.
+// AbstractMachine is the machine over bool; a machine over Symbol<N> keeps one of N symbols on each cell, packed when N is at most 16.
+template <Value V>
+class BasicMachine {
+public:
+	// friend class States;
+	Language<char8_t> language;
+    std::vector<std::unique_ptr<Resource>> Resources;
+
+	std::vector<Token<char8_t>> ResourceRegistry;
+
+	Substrate<V>* Tape;
+	States* StateRegister;
+
+	// Where instructions run by the machine's own commands (run, call) stream their results.
+	DiscardSink Discard;
+	ResultSink* Sink = &Discard;
+
+	// A Frame is a program under execution and how far into it the machine has got: a state's program, or the program of a run command.
+	// Frames is only set while a resumable Execution (see Executor.h) drives the machine; call and run then push a frame instead of recursing into Run,
+	// and the execution evaluates the frame on top until it ends. Each frame is one level of Run, as macro steps count them.
+	struct Frame {
+		unsigned long long state;
+		Medium<char8_t> program; // a copy, so a running program survives being redefined
+		std::size_t pos;
+		bool called; // a called state, which returns to its caller when it ends
+		const std::vector<Instruction>* code; // its decoded instructions, if it has them
+		std::size_t next; // the next of those to evaluate
+		unsigned long long edits; // StateRegister->edits when code was taken, since a later edit may free it
+	};
+	std::vector<Frame>* Frames = nullptr;
+
+	// Starts running program in a new frame on top of Frames.
+	void PushFrame(unsigned long long state, const Medium<char8_t>& program, bool called, const std::vector<Instruction>* code) {
+		Frames->push_back(Frame{ state, program, 0, called, code, 0, StateRegister->edits });
+		++macros.depth;
+	}
+
+	// Ends the frame on top of Frames, returning from it if it was called.
+	void PopFrame() {
+		if (Frames->back().called) Return();
+		macros.Leave();
+		Frames->pop_back();
+	}
+	
+	std::set<Medium<char8_t>> RunComms = { u8"run", u8"rn"};
+	std::set<Medium<char8_t>> TapeComms = { u8"tape", u8"te"};
+	std::set<Medium<char8_t>> StateComms = { u8"state", u8"se"};
 
 	std::set<Medium<char8_t>> sm = {u8"system", u8"sm"};
 	std::set<Medium<char8_t>> ng = {u8"nothing", u8"ng"};
@@ -1418,13 +3575,48 @@ public:
 	std::set<Medium<char8_t>> cl = {u8"call", u8"cl"};
 	std::set<Medium<char8_t>> ed = {u8"end", u8"ed"};
 	std::set<Medium<char8_t>> rt = {u8"reset", u8"rt"};
+	std::set<Medium<char8_t>> ss = {u8"stats", u8"ss"};
+	std::set<Medium<char8_t>> jp = {u8"jump", u8"jp"};
+	std::set<Medium<char8_t>> bh = {u8"branch", u8"bh"};
+	std::set<Medium<char8_t>> pe = {u8"profile", u8"pe"};
+	std::set<Medium<char8_t>> ae = {u8"accelerate", u8"ae"};
+	std::set<Medium<char8_t>> ft = {u8"fingerprint", u8"ft"};
+
+	// Set by a jump, so that whoever is running the current program carries on with the new state's program instead.
+	bool Jumped = false;
+
+	TokenArena arena; // scratch tokens for the instructions being evaluated
+
+	// The command words of the machine and of every resource, each to the concept it names, so Decode finds a command in one lookup.
+	// A word of the machine's takes precedence over a resource's, and a resource's over those of the resources added after it, as Decode tries them.
+	// It is rebuilt whenever a language has gained concepts since, which AddResource always does.
+	struct Dispatch {
+		std::int32_t resource; // -1 for the machine
+		std::uint32_t rule;
+	};
+	std::unordered_map<Medium<char8_t>, Dispatch> dispatch;
+	std::vector<std::size_t> indexed; // how many concepts each language had when dispatch was built, the machine's first
+	std::unordered_map<Medium<char8_t>, std::size_t, TokenHash, std::equal_to<>> ResourceIndex; // resource names to their positions in Resources, searched by view
+
+	Statistics stats;
+	StateProfile profile;
+	MacroSteps<V> macros;
+	std::map<std::pair<std::int32_t, std::uint32_t>, typename MacroSteps<V>::Effect> effects; // of each decoded concept, for macros
 
 
 	void Initialize() {
 		language.AddCharacterInterpretations();
-		language.AddTypeInterpretations();
 
-		language.InterpretMediumFunction(u8"run", RunComms, [this](const Medium<char8_t>& prog) { return this->Run(prog); });
+		// Under an Execution the program runs in a frame of its own once this instruction returns, so nothing of it has been consumed yet.
+		language.InterpretMediumFunction(u8"run", RunComms, [this](const Medium<char8_t>& prog) {
+			Medium<char8_t> program = prog;
+			language.Munch(program); // Remove "run" command
+			if (Frames != nullptr) {
+				PushFrame(StateRegister->state, program, false, nullptr);
+				return 0ULL;
+			}
+			return this->Run(program, *Sink);
+		});
 
 		language.InterpretMediumFunction(u8"system",sm, [this](const Medium<char8_t>& p) { 
 			std::string command(p.begin(), p.end());
@@ -1438,41 +3630,56 @@ public:
 		language.InterpretNullaryVoidFunction(u8"end", ed, [this]() { this->End(); });
 		language.InterpretMediumFunction(u8"call", cl, [this](const Medium<char8_t>& prog) { return this->CallSemantic(prog); });
 		language.InterpretNullaryVoidFunction(u8"reset", rt, [this]() { this->Reset(); });
-
-		AddResource(u8"tape", std::make_unique<Substrate<bool>>(), TapeComms);
+		language.InterpretMediumFunction(u8"stats", ss, [this](const Medium<char8_t>& prog) { return this->StatsSemantic(prog); });
+		language.InterpretMediumFunction(u8"jump", jp, [this](const Medium<char8_t>& prog) { return this->JumpSemantic(prog); });
+		language.InterpretMediumFunction(u8"branch", bh, [this](const Medium<char8_t>& prog) { return this->BranchSemantic(prog); });
+		language.InterpretMediumFunction(u8"profile", pe, [this](const Medium<char8_t>& prog) { return this->ProfileSemantic(prog); });
+		language.InterpretMediumFunction(u8"accelerate", ae, [this](const Medium<char8_t>& prog) { return this->AccelerateSemantic(prog); });
+		language.InterpretNullaryFunction(u8"fingerprint", ft, [this]() { return this->Fingerprint(); });
+
+		AddResource(u8"tape", std::make_unique<Substrate<V>>(), TapeComms);
 		AddResource(u8"state", std::make_unique<States>(), StateComms);
 
-		Tape = static_cast<Substrate<bool>*>(Resources[0].get());
+		Tape = static_cast<Substrate<V>*>(Resources[0].get());
 		StateRegister = static_cast<States*>(Resources[1].get());
+		Tape->stats = &stats;
+		arena.stats = &stats;
+		stats.namer = [this](std::int32_t resource, std::uint32_t rule) {
+			const Language<char8_t>& lang = resource < 0 ? language : Resources[static_cast<std::size_t>(resource)]->language;
+			return Statistics::Name(std::get<0>(lang.I[rule]));
+		};
 	}
 
-	AbstractMachine() {
+	BasicMachine() {
 		Initialize();
 		Tape->NewTape(16);
 	}
 
-	AbstractMachine(const unsigned long& tape_order) {
+	BasicMachine(const unsigned long& tape_order) {
 		Initialize();
 		Tape->NewTape(tape_order);
 	}
 
-	AbstractMachine(const Token<char8_t>& program): AbstractMachine() {
+	BasicMachine(const Token<char8_t>& program): BasicMachine() {
 		LoadAndRun(program);
 	}
 
-	AbstractMachine(const ProgramFile<char8_t>& file): AbstractMachine() {
+	BasicMachine(const ProgramFile<char8_t>& file): BasicMachine() {
 		LoadAndRun(file);
 	}
 
-	AbstractMachine(const unsigned long& tape_order, const Token<char8_t>& program): AbstractMachine(tape_order) {
+	BasicMachine(const unsigned long& tape_order, const Token<char8_t>& program): BasicMachine(tape_order) {
 		LoadAndRun(program);
 	}
 
-	AbstractMachine(const unsigned long& tape_order, const ProgramFile<char8_t>& file): AbstractMachine(tape_order) {
+	BasicMachine(const unsigned long& tape_order, const ProgramFile<char8_t>& file): BasicMachine(tape_order) {
 		LoadAndRun(file);
 	}
 
-	~AbstractMachine() {};
+	// Starts from a precompiled program image: installs its states and tape and runs its entry lines. Images hold bool tapes, so only an AbstractMachine has it. Defined in ProgramImage.h.
+	explicit BasicMachine(const ProgramImage& image) requires std::same_as<V, bool>;
+
+	~BasicMachine() {};
 	
 
 	void System(std::string command) {
@@ -1480,118 +3687,280 @@ public:
 	}
 
 	bool is_resource(const Token<char8_t>& prog) {
-		if (language.is_registered(prog)) {
-			for (const auto& res : ResourceRegistry) {
-				if (res == prog) return true;
-			}
-		}
+		if (const char8_t* symbol = std::get_if<Program<char8_t>>(&prog)) return ResourceIndex.contains(std::u8string_view(symbol, 1));
+		return ResourceIndex.contains(std::get<Medium<char8_t>>(prog));
 	}
 
-	std::vector<std::tuple<Token<char8_t>,std::any, unsigned long long>> Run(const Medium<char8_t>& prog) {
-		//unsigned long long retval = unsigned long long(true);
-
-		//StateRegister->icount = 0;
-
-		std::vector<std::tuple<Token<char8_t>, std::any, unsigned long long>> results;
-		
-		//unsigned long long consumed = 0;
-
-		auto [Concept_Ptr, consumed] = language.is_well_formed(prog);
-
-		//StateRegister->icount = consumed; 
-
-		Medium<char8_t> program{};
+	bool Stale() const {
+		if (indexed.size() != Resources.size() + 1 || indexed[0] != language.I.size()) return true;
+		for (std::size_t r = 0; r < Resources.size(); ++r) {
+			if (indexed[r + 1] != Resources[r]->language.I.size()) return true;
+		}
+		return false;
+	}
 
-		
+	void Reindex() {
+		dispatch.clear();
+		indexed.assign(1, language.I.size());
+		for (const auto& [word, i] : language.Commands) dispatch.emplace(word, Dispatch{ -1, static_cast<std::uint32_t>(i) });
+		for (std::size_t r = 0; r < Resources.size(); ++r) {
+			indexed.push_back(Resources[r]->language.I.size());
+			for (const auto& [word, i] : Resources[r]->language.Commands) dispatch.emplace(word, Dispatch{ static_cast<std::int32_t>(r), static_cast<std::uint32_t>(i) });
+		}
+	}
 
-		if (consumed > 0 && Concept_Ptr != nullptr) {
-			program = Medium<char8_t> (prog.begin(), prog.begin() + consumed);
-			if (is_resource(program)){
-				//Resource* res = std::get<2>(*Concept_Ptr)(prog);
+	// The instruction at the front of prog if it starts with a command word and the command's syntax takes it.
+	// A resource name is left to Decode, as a prefix for the instruction after it.
+	// A command its syntax rejects, such as a write without a value, is Malformed, which ends the search like a match.
+	std::expected<Instruction, Unrecognized> Dispatched(const Token<char8_t>& token, std::any* operands = nullptr) {
+		if (Stale()) Reindex();
+		const Medium<char8_t> word = Language<char8_t>::CommandWord(std::get<Medium<char8_t>>(token));
+		auto found = dispatch.find(word);
+		if (found == dispatch.end() || ResourceIndex.contains(word)) return std::unexpected(Unrecognized::Unknown);
+		const Dispatch d = found->second;
+		const Language<char8_t>& lang = d.resource < 0 ? language : Resources[static_cast<std::size_t>(d.resource)]->language;
+		std::expected<Language<char8_t>::Reading, Unrecognized> consumed = lang.Recognize(d.rule, token);
+		if (!consumed) return std::unexpected(consumed.error());
+		if (operands != nullptr) *operands = std::move(consumed->operands);
+		return Instruction{ 0, static_cast<std::uint32_t>(*consumed), 0, static_cast<std::uint32_t>(*consumed), d.resource, d.rule };
+	}
 
-				auto res = language.Evaluate(*Concept_Ptr,program);
-				program = Medium<char8_t>(prog.begin() + consumed, prog.end());
-				auto subresults = RunResource(std::any_cast<Resource*>(res), program);
+	// Run evaluates every instruction of prog in order and streams each Result into sink as it is produced.
+	// Instructions are separated by ';'. A jump abandons the rest of prog and carries on with the program of the state jumped to.
+	// It returns how much of the program it finished in was consumed, which is all of it unless an exception was thrown.
+	unsigned long long Run(const Medium<char8_t>& prog, ResultSink& sink) {
+		return Run(prog, nullptr, sink);
+	}
 
-				results.insert(results.end(), subresults.begin(), subresults.end());
-			}
-			else 
-				results.push_back(std::make_tuple( std::get<0>(*Concept_Ptr), language.Evaluate(*Concept_Ptr,program), consumed ));
-		}
-		else {
-			// fallback for default interpretation
-			// because if you invoke a resource first, it's done through the resources' language.
-			for (const auto& res : Resources) {
-				auto [Concept_Ptr, consumed] = res->language.is_well_formed(prog);
-				if (consumed > 0) {
-					program = Medium<char8_t>(prog.begin(), prog.begin() + consumed);
-					results.push_back(std::make_tuple(std::get<0>(*Concept_Ptr), res->language.Evaluate(*Concept_Ptr, program), consumed));
+	// Runs prog, using its decoded instructions when code is given. A jump carries on with the decoded program of the state jumped to if it has one.
+	unsigned long long Run(const Medium<char8_t>& prog, const std::vector<Instruction>* code, ResultSink& sink) {
+		const Medium<char8_t>* program = &prog;
+		std::size_t pos = 0, next = 0;
+		typename MacroSteps<V>::Level level(macros);
+		while (true) {
+			if (code != nullptr) {
+				if (next == code->size()) {
+					pos = program->size();
 					break;
 				}
+				const Instruction& instruction = (*code)[next++];
+				pos = instruction.begin + Execute(instruction, *program, sink);
 			}
-		}
+			else {
+				pos = Next(*program, pos);
+				if (pos == program->size()) break;
 
-		if (consumed > 0 && consumed < prog.size()) {
-			program = Medium<char8_t>(prog.begin() + consumed, prog.end());
-			auto subresults = Run(program);
-			results.insert(results.end(), subresults.begin(), subresults.end());
-		}
-		consumed = 0;
-		for (const auto& [concepts, value, length] : results) {
-			consumed += length;
-		}
-		if (consumed < prog.size()) {
-			program = Medium<char8_t>(prog.begin() + consumed, prog.end());
-			if (!str_predicate(std::isspace, program)) {
-				throw std::invalid_argument("Unconsumed input remaining after evaluation\n");
-				return {};
+				std::size_t end = Separator(*program, pos);
+				unsigned long long consumed = Step(*arena.Acquire(program->begin() + pos, program->begin() + end), sink);
+				if (consumed == 0) {
+					throw std::invalid_argument("Unconsumed input remaining after evaluation\n");
+				}
+				pos += consumed;
 			}
-		}
 
-		return results;
+			if (Jumped) {
+				Jumped = false;
+				if (macros.on && !sink.Keeps()) MacroStep();
+				program = &std::get<Medium<char8_t>>(StateRegister->states[StateRegister->state]);
+				code = StateRegister->Decoded(StateRegister->state);
+				pos = next = 0;
+			}
+		}
+		return pos;
 	}
 
-	std::vector<std::tuple<Token<char8_t>, std::any, unsigned long long>> RunResource(Resource* res, const Medium<char8_t>& prog) {
+	// Skips the whitespace and instruction separators from pos on.
+	static std::size_t Next(const Medium<char8_t>& prog, std::size_t pos) {
+		while (pos < prog.size()) {
+			std::size_t width = prog[pos] == u8';' ? 1 : Utf8::SpaceAt(prog, pos);
+			if (width == 0) break;
+			pos += width;
+		}
+		return pos;
+	}
 
-		//unsigned long long retval = unsigned long long(true);
+	// Where the instruction starting at pos ends.
+	static std::size_t Separator(const Medium<char8_t>& prog, std::size_t pos) {
+		std::size_t end = prog.find(u8';', pos);
+		return end == Medium<char8_t>::npos ? prog.size() : end;
+	}
 
-		//StateRegister->icount = 0;
+	// Kept for callers that want every result materialized.
+	std::vector<Result> Run(const Medium<char8_t>& prog) {
+		CollectSink collect;
+		Run(prog, collect);
+		return std::move(collect.results);
+	}
 
-		std::vector<std::tuple<Token<char8_t>, std::any, unsigned long long>> results;
+	// Step evaluates the single instruction at the front of prog and returns how many characters it consumed, or 0 if nothing recognized it.
+	// It throws for a malformed instruction, such as a write without a value.
+	// A resource name prefix ("tape left") selects the resource that evaluates the instruction after it.
+	// The operands the syntax parsed while decoding go to the semantic with the instruction.
+	unsigned long long Step(const Token<char8_t>& prog, ResultSink& sink) {
+		std::any operands;
+		std::expected<Instruction, Unrecognized> instruction = Decode(prog, &operands);
+		if (!instruction) return Undecoded(instruction.error(), std::get<Medium<char8_t>>(prog));
+		return Execute(*instruction, std::get<Medium<char8_t>>(prog), sink, operands);
+	}
 
-		//unsigned long long consumed = 0;
+	// What Step returns for an instruction that did not decode: 0 for one nothing recognized, and an exception for a malformed one.
+	static unsigned long long Undecoded(Unrecognized why, const Medium<char8_t>& prog) {
+		if (why != Unrecognized::Malformed) return 0;
+		throw std::invalid_argument("Malformed instruction: " + std::string(prog.begin(), prog.end()) + "\n");
+	}
 
-		auto [Concept_Ptr, consumed] = res->language.is_well_formed(prog);
+	unsigned long long Step(const Medium<char8_t>& prog, ResultSink& sink) {
+		return Step(*arena.Acquire(prog.begin(), prog.end()), sink);
+	}
 
+	// Evaluates the single instruction at the front of prog in the language of res.
+	// Unless literals is set, an instruction only recognized as a literal is left alone.
+	unsigned long long StepResource(Resource* res, const Medium<char8_t>& prog, ResultSink& sink, bool literals = true) {
+		for (std::size_t r = 0; r < Resources.size(); ++r) {
+			if (Resources[r].get() != res) continue;
+			auto token = arena.Acquire(prog.begin(), prog.end());
+			std::any operands;
+			std::expected<Instruction, Unrecognized> instruction = DecodeResource(r, *token, literals, &operands);
+			if (!instruction) return Undecoded(instruction.error(), prog);
+			return Execute(*instruction, prog, sink, operands);
+		}
+		return 0;
+	}
 
-		//StateRegister->icount = consumed; 
+	// Decode finds the concept that Step would evaluate for the instruction at the front of prog, without evaluating it.
+	// The machine's commands come first, then those of the resources, then the literals of the machine and of the resources, for an instruction that is a Literal.
+	// Commands are found in the dispatch table; the languages are only tried in turn for the other instructions.
+	// Given operands, it leaves there what the syntax that took the instruction parsed of it, for Execute.
+	// An instruction that a syntax rejects is Malformed, and one that nothing takes Unknown.
+	std::expected<Instruction, Unrecognized> Decode(const Token<char8_t>& token, std::any* operands = nullptr) {
+		if (auto instruction = Dispatched(token, operands); instruction || instruction.error() == Unrecognized::Malformed) return instruction;
+		const Medium<char8_t>& prog = std::get<Medium<char8_t>>(token);
+		const Language<char8_t>::Concept* Concept_Ptr = nullptr;
+		Language<char8_t>::Reading consumed;
+		// a token the machine language does not recognize falls through to the resources
+		if (auto found = language.Recognize(token)) std::tie(Concept_Ptr, consumed) = std::move(*found);
+		else if (found.error() == Unrecognized::Malformed) return std::unexpected(Unrecognized::Malformed);
+
+		if (consumed > 0 && Concept_Ptr != nullptr && !language.is_literal(*Concept_Ptr)) {
+			auto named = consumed <= prog.size() ? ResourceIndex.find(std::u8string_view(prog).substr(0, consumed)) : ResourceIndex.end();
+			if (named != ResourceIndex.end()) {
+				const std::size_t r = named->second;
+				std::size_t pos = Language<char8_t>::SkipSpace(prog, consumed);
+				std::expected<Instruction, Unrecognized> instruction = DecodeResource(r, *arena.Acquire(prog.begin() + static_cast<std::ptrdiff_t>(pos), prog.end()), true, operands);
+				if (!instruction) return instruction;
+				instruction->operand += static_cast<std::uint32_t>(pos);
+				instruction->length += static_cast<std::uint32_t>(pos);
+				return instruction;
+			}
+			if (operands != nullptr) *operands = std::move(consumed.operands);
+			return Instruction{ 0, static_cast<std::uint32_t>(consumed), 0, static_cast<std::uint32_t>(consumed), -1, Index(language, Concept_Ptr) };
+		}
 
-		Medium<char8_t> program{};
+		// The commands of every resource take precedence over literals.
+		for (std::size_t r = 0; r < Resources.size(); ++r) {
+			if (auto instruction = DecodeResource(r, token, false, operands); instruction || instruction.error() == Unrecognized::Malformed) return instruction;
+		}
+		if (consumed > 0 && Concept_Ptr != nullptr && Literal(prog)) {
+			if (operands != nullptr) *operands = std::move(consumed.operands);
+			return Instruction{ 0, static_cast<std::uint32_t>(consumed), 0, static_cast<std::uint32_t>(consumed), -1, Index(language, Concept_Ptr) };
+		}
+		for (std::size_t r = 0; r < Resources.size(); ++r) {
+			if (auto instruction = DecodeResource(r, token, true, operands); instruction || instruction.error() == Unrecognized::Malformed) return instruction;
+		}
+		return std::unexpected(Unrecognized::Unknown);
+	}
 
+	// Whether a literal may take the instruction prog. A literal is a single word, and never one that starts with a letter:
+	// that is a command word or an unknown one, and an instruction no command takes is an error, not a value that does nothing.
+	static bool Literal(const Medium<char8_t>& prog) {
+		const std::size_t begin = Language<char8_t>::SkipSpace(prog, 0);
+		if (begin == prog.size()) return false;
+		if (Language<char8_t>::SkipSpace(prog, Language<char8_t>::SkipWord(prog, begin)) != prog.size()) return false;
+		std::size_t pos = begin;
+		return !Utf8::IsLetter(Utf8::Decode(prog, pos));
+	}
 
-		if (consumed > 0 && Concept_Ptr != nullptr) {
-			program = Medium<char8_t>(prog.begin(), prog.begin() + consumed);
-			results.push_back(std::make_tuple(std::get<0>(*Concept_Ptr), res->language.Evaluate(*Concept_Ptr, program), consumed));
+	std::expected<Instruction, Unrecognized> DecodeResource(std::size_t r, const Token<char8_t>& prog, bool literals = true, std::any* operands = nullptr) {
+		Language<char8_t>& lang = Resources[r]->language;
+		if (auto rule = lang.Command(std::get<Medium<char8_t>>(prog))) {
+			std::expected<Language<char8_t>::Reading, Unrecognized> taken = lang.Recognize(*rule, prog);
+			if (taken && operands != nullptr) *operands = std::move(taken->operands);
+			if (taken) return Instruction{ 0, static_cast<std::uint32_t>(*taken), 0, static_cast<std::uint32_t>(*taken), static_cast<std::int32_t>(r), static_cast<std::uint32_t>(*rule) };
+			if (taken.error() == Unrecognized::Malformed) return std::unexpected(Unrecognized::Malformed);
 		}
+		std::expected<Language<char8_t>::Match, Unrecognized> found = lang.Recognize(prog);
+		if (!found) return std::unexpected(found.error());
+		auto& [Concept_Ptr, consumed] = *found;
+		if (lang.is_literal(*Concept_Ptr) && (!literals || !Literal(std::get<Medium<char8_t>>(prog)))) return std::unexpected(Unrecognized::Unknown);
+		if (operands != nullptr) *operands = std::move(consumed.operands);
+		return Instruction{ 0, static_cast<std::uint32_t>(consumed), 0, static_cast<std::uint32_t>(consumed), static_cast<std::int32_t>(r), Index(lang, Concept_Ptr) };
+	}
 
-		if (consumed > 0 && consumed < prog.size()) {
-			program = Medium<char8_t>(prog.begin() + consumed, prog.end());
-			auto subresults = Run(program);
-			results.insert(results.end(), subresults.begin(), subresults.end());
+	// Decodes the program of st ahead of time, so running it skips recognition.
+	// A program with an instruction that does not decode is left to be recognized as it runs.
+	bool Precompile(unsigned long long st) {
+		if (!StateRegister->states.contains(st)) return false;
+		Statistics::Timer timer(stats, Statistics::Phase::Decode);
+		const Medium<char8_t>& prog = std::get<Medium<char8_t>>(StateRegister->states[st]);
+		std::vector<Instruction> code;
+		std::size_t pos = 0;
+		while (true) {
+			pos = Next(prog, pos);
+			if (pos == prog.size()) break;
+			std::size_t end = Separator(prog, pos);
+			std::expected<Instruction, Unrecognized> instruction = Decode(*arena.Acquire(prog.begin() + pos, prog.begin() + end));
+			if (!instruction) return false;
+			instruction->begin += static_cast<std::uint32_t>(pos);
+			instruction->operand += static_cast<std::uint32_t>(pos);
+			code.push_back(*instruction);
+			pos += instruction->length;
 		}
-		consumed = 0;
-		for (const auto& [concepts, value, length] : results) {
-			consumed += length;
+		StateRegister->decoded[st] = std::move(code);
+		stats.Allocation();
+		return true;
+	}
+
+	static std::uint32_t Index(const Language<char8_t>& lang, const Language<char8_t>::Concept* c) {
+		return static_cast<std::uint32_t>(c - lang.I.data());
+	}
+
+	// Evaluates a decoded instruction of text, the program its offsets are into, and returns how many characters it consumed.
+	// operands are what its syntax parsed when it was just decoded; a precompiled instruction has none, and its semantic parses the text.
+	unsigned long long Execute(const Instruction& instruction, const Medium<char8_t>& text, ResultSink& sink, const std::any& operands = {}) {
+		Language<char8_t>& lang = instruction.resource < 0 ? language : Resources[static_cast<std::size_t>(instruction.resource)]->language;
+		const Language<char8_t>::Concept& C = lang.I[instruction.rule];
+		auto program = arena.Acquire(text.begin() + instruction.operand, text.begin() + instruction.operand + instruction.size);
+		if (macros.Recording()) {
+			auto [effect, fresh] = effects.try_emplace({ instruction.resource, instruction.rule });
+			if (fresh) effect->second = MacroSteps<V>::EffectOf(instruction.resource, Statistics::Name(std::get<0>(C)), lang.is_literal(C));
+			macros.Observe(effect->second, *Tape);
 		}
-		if (consumed < prog.size()) {
-			program = Medium<char8_t>(prog.begin() + consumed, prog.end());
-			if (!str_predicate(std::isspace, program)) {
-				throw std::invalid_argument("Unconsumed input remaining after evaluation\n");
-				return {};
-			}
+		Count(instruction);
+		sink.Push(std::get<0>(C), lang.Evaluate(C, *program, operands), instruction.size);
+		return instruction.length;
+	}
+
+	// Bookkeeping for every evaluated instruction. The instruction counter is bumped before evaluation so a call saves the position after it.
+	void Count(const Instruction& instruction) {
+		++StateRegister->icount;
+		++stats.instructions;
+		stats.Executed(instruction.resource, instruction.rule);
+		if (profile.period != 0 && --profile.countdown == 0) profile.Sample(StateRegister->previous, StateRegister->state);
+	}
+
+	// Evaluates the first instruction of prog in res, then runs the rest of prog in the machine.
+	unsigned long long RunResource(Resource* res, const Medium<char8_t>& prog, ResultSink& sink) {
+		unsigned long long consumed = StepResource(res, prog, sink);
+		if (consumed == 0) {
+			throw std::invalid_argument("Unconsumed input remaining after evaluation\n");
 		}
+		return consumed + Run(Medium<char8_t>(prog.begin() + consumed, prog.end()), sink);
+	}
 
-		return results;
+	std::vector<Result> RunResource(Resource* res, const Medium<char8_t>& prog) {
+		CollectSink collect;
+		RunResource(res, prog, collect);
+		return std::move(collect.results);
 	}
 
 	unsigned long long ResNameSyntax(const Token<char8_t>& name, const Token<char8_t>& prog, const std::set<Medium<char8_t>>& comnames) {
@@ -1600,30 +3969,30 @@ public:
 		
 		if (std::holds_alternative<Medium<char8_t>>(name) && std::holds_alternative<Medium<char8_t>>(prog)){
 			
-			if (language.is_well_formed(name).second != 0 ) {
-				Medium<char8_t> command = language.Lick(std::get<Medium<char8_t>>(prog));
-				if (!command.empty() && comnames.contains(std::get<Medium<char8_t>>(ToLower(command)))){
+			if (language.is_word(name)) {
+				Medium<char8_t> command = Language<char8_t>::CommandWord(std::get<Medium<char8_t>>(prog));
+				if (!command.empty() && comnames.contains(command)){
 					return command.size();
 				}
 				return 0;
 			}
-			throw std::invalid_argument("Resource name must be a word without an interpretation\n");
-			return 0;
+			return Language<char8_t>::Rejected; // a resource name must be a word without an interpretation
 		}
 		return 0;
 	}
 
-	std::any ResNameSemantic(const Token<char8_t>& prog, Resource* res) {
+	std::any ResNameSemantic(const Token<char8_t>&, Resource* res) {
 		return res;
 	}
 
 	void AddResource(const Token<char8_t>& name, std::unique_ptr<Resource> res, std::set<Medium<char8_t>> comnames ) {
 		if (language.is_word(name) && !language.is_registered(name)) {
-			Resources.push_back(std::move(res));
 			Resource* resPtr = res.get();
+			ResourceIndex[Statistics::Name(name)] = Resources.size();
+			Resources.push_back(std::move(res));
 			ResourceRegistry.push_back(name);
 			language.Interpret(
-				std::set<Program<char8_t>>{},
+				CharClass{},
 				name,
 				[this, name, comnames](const Token<char8_t>& prog) { return this->ResNameSyntax(name, prog, comnames); },
 				[this, name, resPtr](const Token<char8_t>& prog) { return this->ResNameSemantic(prog, resPtr); }
@@ -1637,8 +4006,11 @@ public:
 		Tape->NewTape(Tape->order);
 
 		StateRegister->states.clear();
+		StateRegister->decoded.clear();
+		StateRegister->named.clear();
 		StateRegister->instnum.clear();
 		StateRegister->previous.clear();
+		macros.Clear();
 
 		StateRegister->Load (u8"nothing");
 	}
@@ -1648,8 +4020,11 @@ public:
 		Tape->NewTape(n);
 
 		StateRegister->states.clear();
+		StateRegister->decoded.clear();
+		StateRegister->named.clear();
 		StateRegister->instnum.clear();
 		StateRegister->previous.clear();
+		macros.Clear();
 		StateRegister->Load (u8"ng");
 	}
 
@@ -1671,16 +4046,23 @@ public:
 
 	void Nothing() {}
 
+	// How End draws tape cell i.
+	char Glyph(std::size_t i) const {
+		const auto cell = Tape->Tape[i];
+		if constexpr (std::is_same_v<V, bool>) return cell ? '1' : '0';
+		else if constexpr (requires { V(cell).Glyph(); }) return V(cell).Glyph();
+		else if constexpr (Char<V>) return cell == V{} ? '_' : static_cast<char>(cell);
+		else return cell == typename Medium<V>::value_type{} ? '0' : '#';
+	}
+
 	void End() {
 		long long zero = 1LL << (Tape->order - 1);
 		std::string mess = "";
 		std::string lt = "", rt = "";
 		long long block = Tape->head / 64;
 		for (unsigned i = 0; i < 64; i++) {
-			if (Tape->Tape[(zero / 64 + block - 1) * 64 + i + 1] == false) lt += "0";
-			else lt += "1";
-			if (Tape->Tape[(zero / 64 + block + 1) * 64 - i] == false) rt += "0";
-			else rt += "1";
+			lt += Glyph(static_cast<std::size_t>((zero / 64 + block - 1) * 64 + i + 1));
+			rt += Glyph(static_cast<std::size_t>((zero / 64 + block + 1) * 64 - i));
 		}
 
 		if (Tape->head >= 0) {
@@ -1724,25 +4106,41 @@ public:
 			StateRegister->previous.push_back(StateRegister->state);
 			StateRegister->instnum.push_back(StateRegister->icount);
 			StateRegister->state = state;
+			StateRegister->icount = 0;
+
+			++stats.calls;
+			stats.depth = std::max<unsigned long long>(stats.depth, StateRegister->previous.size());
 
-			retval = Run(std::get<Medium<char8_t>>(StateRegister->states[state]));
+			if (Frames != nullptr) {
+				// A resumable execution is driving the machine: it runs the called state and returns from it.
+				PushFrame(state, std::get<Medium<char8_t>>(StateRegister->states[state]), true, StateRegister->Decoded(state));
+				return true;
+			}
+
+			Run(std::get<Medium<char8_t>>(StateRegister->states[state]), StateRegister->Decoded(state), *Sink);
+			retval = true;
 
-			StateRegister->state = StateRegister->previous.back();
-			StateRegister->previous.pop_back();
-			StateRegister->icount = StateRegister->instnum.back();
-			StateRegister->instnum.pop_back();
+			Return();
 		}
 		else std::cerr << "State not in memory";
 		return retval;
 	}
 
+	// Return from a called state to the one that called it.
+	void Return() {
+		StateRegister->state = StateRegister->previous.back();
+		StateRegister->previous.pop_back();
+		StateRegister->icount = StateRegister->instnum.back();
+		StateRegister->instnum.pop_back();
+	}
+
 	std::any CallSemantic(const Medium<char8_t>& program) {
-		Medium<char8_t> prog = program;
-		language.Munch(prog); 
-		if (!prog.empty()) {
-			prog = language.Munch(prog);
+		std::size_t pos = 0;
+		language.Bite(program, pos); // Skip "call" command
+		if (pos < program.size()) {
+			Medium<char8_t> prog = language.Bite(program, pos);
 			if (!prog.empty()) {
-				if(str_predicate(std::isalpha, prog)) {
+				if(str_name(prog)) {
 					return Call(StateRegister->hasher(prog));
 				}
 				else if(str_predicate(std::isdigit, prog)) {
@@ -1753,21 +4151,124 @@ public:
 		return false;
 	}
 
-	std::any LoadAndRun(Token<char8_t> program) {
-		unsigned long ld = StateRegister->Load(program).second;
+	// Loads a program into the state register, timing it as the load phase.
+	// A program must be well-formed UTF-8. It is checked once here, so the tokenizers can decode it without checking again.
+	unsigned long long LoadState(Token<char8_t> program) {
+		Statistics::Timer timer(stats, Statistics::Phase::Load);
+		if (const Medium<char8_t>* text = std::get_if<Medium<char8_t>>(&program)) {
+			std::size_t bad = Utf8::Invalid(*text);
+			if (bad != Utf8::npos) throw std::invalid_argument("Program is not valid UTF-8 at byte " + std::to_string(bad) + "\n");
+		}
+		unsigned long long st = StateRegister->Load(std::move(program)).second;
+		macros.Clear(); // a step may have called the state just redefined
+		return st;
+	}
+
+	// Runs a loaded state with sink installed as the machine's sink, timing it as the run phase.
+	unsigned long long RunState(unsigned long long st, ResultSink& sink) {
+		ResultSink* outer = Sink;
+		Sink = &sink;
+		Statistics::Timer timer(stats, Statistics::Phase::Run);
+		try {
+			unsigned long long consumed = Run(std::get<Medium<char8_t>>(StateRegister->states[st]), StateRegister->Decoded(st), sink);
+			Sink = outer;
+			return consumed;
+		}
+		catch (...) {
+			Sink = outer;
+			throw;
+		}
+	}
+
+	// LoadAndRun streams the results of the loaded program into sink. Instructions that call other states stream into the same sink.
+	// The lines of a file that name a state only define it; the other lines run in order.
+	unsigned long long LoadAndRun(const Token<char8_t>& program, ResultSink& sink) {
+		unsigned long long ld = LoadState(program);
+		if (!StateRegister->states.contains(ld)) return 0;
+		return RunState(ld, sink);
+	}
+
+	unsigned long long LoadAndRun(const ProgramFile<char8_t>& file, ResultSink& sink) {
+		std::vector<unsigned long long> StateStack;
+		for (const Medium<char8_t>& line : file) {
+			StateStack.push_back(LoadState(line));
+		}
+
+		unsigned long long consumed = 0;
+		for (unsigned long long st : StateStack) {
+			if (StateRegister->states.contains(st) && !StateRegister->named.contains(st)) {
+				consumed += RunState(st, sink);
+			}
+		}
+		return consumed;
+	}
+
+	// A state is named by a word (hashed as Load does) or by its number.
+	std::optional<unsigned long long> StateId(const Medium<char8_t>& name) {
+		if (name.empty()) return std::nullopt;
+		if (str_name(name)) return StateRegister->hasher(name);
+		if (str_predicate(std::isdigit, name)) return std::stoull(std::string(name.begin(), name.end()));
+		return std::nullopt;
+	}
+
+	// Transfers control to state without returning: the rest of the current program is abandoned.
+	bool Jump(unsigned long long state) {
+		if (!StateRegister->states.contains(state)) {
+			std::cerr << "State not in memory";
+			return false;
+		}
+		StateRegister->state = state;
+		StateRegister->icount = 0;
+		Jumped = true;
+		return true;
+	}
+
+	std::any JumpSemantic(const Medium<char8_t>& program) {
+		std::size_t pos = 0;
+		language.Bite(program, pos); // Skip "jump" command
+		if (auto st = StateId(language.Bite(program, pos))) return Jump(*st);
+		return false;
+	}
+
+	// "branch s0 s1 ..." reads the scanned cell and jumps to the state listed at that symbol's position.
+	// If no state is listed for the symbol, execution carries on with the next instruction.
+	std::any BranchSemantic(const Medium<char8_t>& program) {
+		std::size_t pos = 0;
+		language.Bite(program, pos); // Skip "branch" command
+		std::size_t symbol = 0;
+		if constexpr (requires { static_cast<std::size_t>(Tape->Read()); }) symbol = static_cast<std::size_t>(Tape->Read());
+		for (std::size_t i = 0; pos < program.size(); ++i) {
+			Medium<char8_t> name = language.Bite(program, pos);
+			if (i == symbol) {
+				if (auto st = StateId(name)) return Jump(*st);
+				return false;
+			}
+		}
+		return false;
+	}
+
+	std::any LoadAndRun(const Token<char8_t>& program) {
+		unsigned long long ld = LoadState(program);
 		if (StateRegister->states.contains(ld)) {
-			return Run((std::get<Medium<char8_t>>(StateRegister->states[ld])));
+			CollectSink collect;
+			RunState(ld, collect);
+			return std::move(collect.results);
 		} else return false;
 	}
-	std::any LoadAndRun(ProgramFile<char8_t> file) {
-		std::vector<unsigned long> StateStack;
+	std::any LoadAndRun(const ProgramFile<char8_t>& file) {
+		std::vector<unsigned long long> StateStack;
 		std::vector<std::any> results;
-		for (Medium<char8_t> line : file) {
-			StateStack.push_back(StateRegister->Load(line).second);
+		for (const Medium<char8_t>& line : file) {
+			StateStack.push_back(LoadState(line));
 		}
-		for (unsigned long st : StateStack) {
-			if (StateRegister->states.contains(st)) {
-				results.push_back(Run((std::get<Medium<char8_t>>(StateRegister->states[st]))));
+		for (unsigned long long st : StateStack) {
+			if (StateRegister->named.contains(st)) {
+				results.push_back(std::any{}); // a definition, not run
+			}
+			else if (StateRegister->states.contains(st)) {
+				CollectSink collect;
+				RunState(st, collect);
+				results.push_back(std::move(collect.results));
 			}
 			 else {
 				results.push_back(false);
@@ -1776,12 +4277,97 @@ public:
 		return results;
 	}
 
+	// stats returns the whole Statistics record, "stats json" its JSON export and "stats <counter>" a single counter (or the count of a concept).
+	std::any StatsSemantic(const Medium<char8_t>& program) {
+		Medium<char8_t> prog = program;
+		language.Munch(prog); // Remove "stats" command
+		if (prog.empty()) return stats;
+		Medium<char8_t> name = std::get<Medium<char8_t>>(ToLower(language.Munch(prog)));
+		if (name == u8"json") return stats.ToJSON();
+		if (auto counter = stats.Counter(name)) return *counter;
+		return std::any{};
+	}
+
+	// The name a state was defined with, or else its number.
+	std::string StateName(unsigned long long state) const {
+		auto found = StateRegister->named.find(state);
+		if (found != StateRegister->named.end()) return std::string(found->second.begin(), found->second.end());
+		return std::to_string(state);
+	}
+
+	// "profile N" samples the call chain every N instructions, "profile off" stops, "profile" returns the folded stacks and "profile table" the hottest states.
+	std::any ProfileSemantic(const Medium<char8_t>& program) {
+		Medium<char8_t> prog = program;
+		language.Munch(prog); // Remove "profile" command
+		Medium<char8_t> arg = std::get<Medium<char8_t>>(ToLower(language.Munch(prog)));
+		auto name = [this](unsigned long long st) { return StateName(st); };
+		std::ostringstream os;
+		if (arg.empty()) profile.WriteFolded(os, name);
+		else if (arg == u8"table") profile.WriteTable(os, name);
+		else if (arg == u8"off") profile.Stop();
+		else if (str_predicate(std::isdigit, arg)) profile.Start(std::stoull(std::string(arg.begin(), arg.end())));
+		else return std::any{};
+		return os.str();
+	}
+
+	// Turns macro steps on or off. With them on, a jump into a state whose program already ran from the same cells around the head
+	// replays what it did instead of evaluating it, as many times in a row as it applies, and records it otherwise.
+	// stats.instructions counts the instructions evaluated and stats.simulated the ones replayed steps stand for; stats.executed only counts the evaluated ones.
+	// Replayed steps stream no results, so steps are only taken while running into a sink that drops them, such as Discard.
+	// Defining or removing any state drops every step, since a step covers the states its state calls as well.
+	void Accelerate(bool on) {
+		macros.Clear();
+		macros.on = on && std::equality_comparable<V>;
+	}
+
+	// Ends the macro step that a jump just finished, replays the steps that follow from the new state, and starts recording the next one.
+	void MacroStep() {
+		if constexpr (std::equality_comparable<V>) {
+			if (macros.edits != StateRegister->edits) {
+				macros.Clear();
+				macros.edits = StateRegister->edits;
+			}
+			if (!macros.Outer()) return;
+			if (macros.Recording()) macros.End(*Tape, StateRegister->state, stats.instructions);
+			while (const auto* step = macros.Match(*Tape, StateRegister->state)) {
+				MacroSteps<V>::Apply(*Tape, *step);
+				StateRegister->state = step->next;
+				StateRegister->icount = 0;
+				++stats.macrosteps;
+				stats.simulated += step->instructions;
+			}
+			macros.Begin(StateRegister->state, Tape->head, stats.instructions);
+		}
+	}
+
+	// The configuration of the machine as one number: the tape and head (see Substrate::Hash), the state, how far into it the machine is, and the states that called it.
+	// It costs the same however long the tape is, so a program can check for a configuration it has been in before as often as it likes.
+	std::uint64_t Fingerprint() {
+		std::uint64_t h = Tape->Hash() ^ Substrate<V>::Mix(StateRegister->state);
+		h = Substrate<V>::Mix(h ^ StateRegister->icount);
+		for (std::size_t i = 0; i < StateRegister->previous.size(); ++i) {
+			h = Substrate<V>::Mix(h ^ StateRegister->previous[i]);
+			h = Substrate<V>::Mix(h ^ StateRegister->instnum[i]);
+		}
+		return h;
+	}
+
+	// "accelerate" turns macro steps on and "accelerate off" turns them off.
+	std::any AccelerateSemantic(const Medium<char8_t>& program) {
+		std::size_t pos = 0;
+		language.Bite(program, pos); // Skip "accelerate" command
+		Accelerate(std::get<Medium<char8_t>>(ToLower(language.Bite(program, pos))) != u8"off");
+		return macros.on;
+	}
+
 	void Reset() {
 		Start();
 		End();
 	}
 };
 
+using AbstractMachine = BasicMachine<bool>;
+
 
 
 //template<Text T>
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Language.h"
+
+// A MappedFile is a whole file mapped read-only into memory.
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) throw std::invalid_argument("Cannot open file " + path + "\n");
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size)) {
+			CloseHandle(file);
+			throw std::invalid_argument("Cannot stat file " + path + "\n");
+		}
+		length = static_cast<std::size_t>(size.QuadPart);
+		if (length > 0) {
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping == nullptr) {
+				CloseHandle(file);
+				throw std::invalid_argument("Cannot map file " + path + "\n");
+			}
+			data = static_cast<const char8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+#else
+		fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) throw std::invalid_argument("Cannot open file " + path + "\n");
+		struct stat st{};
+		if (fstat(fd, &st) != 0) {
+			close(fd);
+			throw std::invalid_argument("Cannot stat file " + path + "\n");
+		}
+		length = static_cast<std::size_t>(st.st_size);
+		if (length > 0) {
+			void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p == MAP_FAILED) {
+				close(fd);
+				throw std::invalid_argument("Cannot map file " + path + "\n");
+			}
+			data = static_cast<const char8_t*>(p);
+			madvise(p, length, MADV_SEQUENTIAL);
+		}
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() {
+#ifdef _WIN32
+		if (data != nullptr) UnmapViewOfFile(data);
+		if (mapping != nullptr) CloseHandle(mapping);
+		CloseHandle(file);
+#else
+		if (data != nullptr) munmap(const_cast<char8_t*>(data), length);
+		close(fd);
+#endif
+	}
+
+	std::size_t size() const { return length; }
+
+	std::u8string_view Text() const { return std::u8string_view(data, length); }
+
+protected:
+	const char8_t* data = nullptr;
+	std::size_t length = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
+
+// A MappedProgram is a program source file mapped into memory and read a line at a time, one line per state as in a ProgramFile.
+// Lines are views into the mapping, so a line is only copied when it is loaded as a state.
+class MappedProgram : public MappedFile {
+public:
+	// A stream pages the file in and out this many bytes at a time, so the memory it holds does not grow with the file.
+	static constexpr std::size_t Window = std::size_t(4) << 20;
+
+	explicit MappedProgram(const std::string& path) : MappedFile(path) {}
+
+	// Calls f with every line that is not blank, without its line terminator, in order.
+	// With release set, the pages behind the line are dropped and the ones ahead requested as it goes.
+	template <typename F>
+	void Lines(F f, bool release = false) const {
+		std::size_t pos = 0, window = 0;
+		while (pos < length) {
+			if (release && pos / Window != window) {
+				window = pos / Window;
+				Advise(window);
+			}
+
+			const void* found = std::memchr(data + pos, '\n', length - pos);
+			std::size_t end = found ? static_cast<std::size_t>(static_cast<const char8_t*>(found) - data) : length;
+			std::size_t last = end;
+			if (last > pos && data[last - 1] == u8'\r') --last;
+
+			std::u8string_view line(data + pos, last - pos);
+			if (!Blank(line)) f(line);
+			pos = end + 1;
+		}
+	}
+
+	// Loads every line, then runs the ones that do not name a state in order, as AbstractMachine::LoadAndRun does for a ProgramFile.
+	// Every line stays loaded, so a line can call or jump to a state named further down.
+	unsigned long long LoadAndRun(AbstractMachine& machine, ResultSink& sink) const {
+		std::vector<unsigned long long> StateStack;
+		Lines([&](std::u8string_view line) {
+			StateStack.push_back(machine.LoadState(Medium<char8_t>(line)));
+		});
+
+		unsigned long long consumed = 0;
+		for (unsigned long long st : StateStack) {
+			if (machine.StateRegister->states.contains(st) && !machine.StateRegister->named.contains(st)) {
+				consumed += machine.RunState(st, sink);
+			}
+		}
+		return consumed;
+	}
+
+	// Runs each line as soon as it is loaded, so execution starts before the file is read and loading overlaps it.
+	// A line can only reach the states named above it. A line that does not name a state is dropped from the state table once it has run,
+	// so for a file of instructions the memory held is the named states and a window of the file, however large the file is.
+	unsigned long long Stream(AbstractMachine& machine, ResultSink& sink) const {
+		States& states = *machine.StateRegister;
+		unsigned long long consumed = 0;
+		Lines([&](std::u8string_view line) {
+			std::size_t before = states.states.size();
+			unsigned long long st = machine.LoadState(Medium<char8_t>(line));
+			if (!states.states.contains(st) || states.named.contains(st)) return;
+			consumed += machine.RunState(st, sink);
+			if (states.states.size() > before && !states.accepting.contains(st)) states.Erase(st);
+		}, true);
+		return consumed;
+	}
+
+	// Copies the lines into a ProgramFile, for code that wants one.
+	ProgramFile<char8_t> File() const {
+		ProgramFile<char8_t> file;
+		Lines([&file](std::u8string_view line) { file.emplace_back(line); });
+		return file;
+	}
+
+private:
+	static bool Blank(std::u8string_view line) {
+		for (std::size_t i = 0; i < line.size();) {
+			std::size_t width = Utf8::SpaceAt(line, i);
+			if (width == 0) return false;
+			i += width;
+		}
+		return true;
+	}
+
+	// A stream reading a line that starts in window w is done with window w - 1, and reads window w + 1 ahead while w runs.
+	void Advise(std::size_t w) const {
+#ifndef _WIN32
+		char* base = const_cast<char*>(reinterpret_cast<const char*>(data));
+		if (w >= 1) madvise(base + (w - 1) * Window, Window, MADV_DONTNEED);
+		std::size_t ahead = (w + 1) * Window;
+		if (ahead < length) madvise(base + ahead, std::min(Window, length - ahead), MADV_WILLNEED);
+#else
+		(void)w;
+#endif
+	}
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <filesystem>
+#include <random>
+#include <system_error>
+#include <algorithm>
+
+#include "ProgramImage.h"
+
+// A ProgramCache is a directory of program images, each named by a hash of its program text, the tape order and the languages it was compiled for.
+// Running a program the cache has seen maps its image instead of loading and decoding the text again, in this process or in any later one.
+// The hash only names the file: an image keeps the program text it was compiled from, and a hit must match it line for line,
+// so two programs whose hashes collide only cost each other a compile.
+//
+// Processes can share a directory. An image is written under a name of its own and renamed into place, so a reader only ever maps a whole image,
+// and two processes compiling the same program race harmlessly to put the same bytes under the same name. A mapped image stays readable when it is replaced or removed,
+// which is why a compiled image is mapped before it is renamed: another process evicting it right away cannot take it from under us.
+// Once the images outgrow the capacity, the least recently used ones are removed; a hit marks its image used by touching its modification time.
+class ProgramCache {
+public:
+	static constexpr std::uintmax_t DefaultCapacity = std::uintmax_t(256) << 20;
+
+	unsigned long long hits = 0;
+	unsigned long long misses = 0;
+
+	explicit ProgramCache(std::filesystem::path dir, std::uintmax_t capacity = DefaultCapacity) : directory(std::move(dir)), capacity(capacity) {
+		std::error_code ec;
+		std::filesystem::create_directories(directory, ec);
+		if (!std::filesystem::is_directory(directory, ec)) throw std::invalid_argument("Cannot create program cache " + directory.string() + "\n");
+	}
+
+	// Replaces the states and tape of machine by those of file loaded into a fresh machine of the same tape order, then runs the entry lines,
+	// as LoadAndRun(file) on a fresh machine would.
+	unsigned long long LoadAndRun(AbstractMachine& machine, const ProgramFile<char8_t>& file, ResultSink& sink) {
+		std::unique_ptr<ProgramImage> image = Image(machine, file);
+		image->Install(machine);
+		return image->Run(machine, sink);
+	}
+
+	// The image of file for machine, mapped from the cache, or compiled into it first on a miss.
+	// Only a machine of the standard languages is cached, since the image is compiled on a fresh one.
+	std::unique_ptr<ProgramImage> Image(const AbstractMachine& machine, const ProgramFile<char8_t>& file) {
+		const std::filesystem::path path = Path(Key(machine, file));
+		if (std::unique_ptr<ProgramImage> image = Open(path, machine, file)) {
+			++hits;
+			return image;
+		}
+		++misses;
+		std::unique_ptr<ProgramImage> image = Compile(machine, file, path);
+		Evict();
+		return image;
+	}
+
+	// Names the image of a program for machine: FNV-1a over the language fingerprint, the tape order and every line.
+	static std::uint64_t Key(const AbstractMachine& machine, const ProgramFile<char8_t>& file) {
+		std::uint64_t hash = 14695981039346656037ULL;
+		auto mix = [&hash](std::uint64_t value) {
+			for (int i = 0; i < 8; ++i) {
+				hash ^= (value >> (8 * i)) & 0xFF;
+				hash *= 1099511628211ULL;
+			}
+		};
+		mix(ProgramImage::Fingerprint(machine));
+		mix(machine.Tape->order);
+		mix(file.size());
+		for (const Medium<char8_t>& line : file) {
+			mix(line.size());
+			for (char8_t c : line) {
+				hash ^= c;
+				hash *= 1099511628211ULL;
+			}
+		}
+		return hash;
+	}
+
+	// Where the image of the program with key lives.
+	std::filesystem::path Path(std::uint64_t key) const {
+		static constexpr char Hex[] = "0123456789abcdef";
+		std::string name(16, '0');
+		for (int i = 15; i >= 0; --i, key >>= 4) name[static_cast<std::size_t>(i)] = Hex[key & 0xF];
+		return directory / (name + ".amim");
+	}
+
+	// Removes the least recently used images until the rest fit in the capacity, and the partial images of writers that died long ago.
+	// Another process may be removing the same files; a file that is already gone, or that cannot be removed, is passed over.
+	void Evict() {
+		struct Entry {
+			std::filesystem::path path;
+			std::filesystem::file_time_type used;
+			std::uintmax_t size;
+		};
+		std::vector<Entry> images;
+		std::uintmax_t total = 0;
+		const auto stale = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+			std::error_code fec;
+			if (!entry.is_regular_file(fec)) continue;
+			const std::filesystem::file_time_type used = entry.last_write_time(fec);
+			if (fec) continue;
+			if (entry.path().extension() == ".tmp") {
+				if (used < stale) std::filesystem::remove(entry.path(), fec);
+				continue;
+			}
+			if (entry.path().extension() != ".amim") continue;
+			const std::uintmax_t size = entry.file_size(fec);
+			if (fec) continue;
+			images.push_back({ entry.path(), used, size });
+			total += size;
+		}
+		if (total <= capacity) return;
+
+		std::sort(images.begin(), images.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+		for (const Entry& image : images) {
+			if (total <= capacity) break;
+			std::error_code rec;
+			std::filesystem::remove(image.path, rec);
+			total -= image.size;
+		}
+	}
+
+private:
+	std::filesystem::path directory;
+	std::uintmax_t capacity;
+
+	// The image at path if it is a readable image of file for machine. Only then does opening it mark it used.
+	static std::unique_ptr<ProgramImage> Open(const std::filesystem::path& path, const AbstractMachine& machine, const ProgramFile<char8_t>& file) {
+		std::error_code ec;
+		if (!std::filesystem::is_regular_file(path, ec)) return nullptr; // not there
+		std::unique_ptr<ProgramImage> image;
+		try {
+			image = std::make_unique<ProgramImage>(path.string());
+		}
+		catch (const std::invalid_argument&) { return nullptr; } // gone since, or an image of another version, which is compiled again
+		if (!image->Fits(machine) || image->Order() != machine.Tape->order || !image->Holds(file)) return nullptr; // another program under the same name
+		std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+		return image;
+	}
+
+	// Compiles file on a fresh machine of the tape order of machine into a file of its own, maps it and renames it to path.
+	std::unique_ptr<ProgramImage> Compile(const AbstractMachine& machine, const ProgramFile<char8_t>& file, const std::filesystem::path& path) {
+		AbstractMachine compiled(machine.Tape->order);
+		if (ProgramImage::Fingerprint(compiled) != ProgramImage::Fingerprint(machine)) {
+			throw std::invalid_argument("Program cache only holds programs for machines of the standard languages\n");
+		}
+		std::vector<unsigned long long> entry = ProgramImage::Load(compiled, file);
+
+		std::random_device random;
+		std::filesystem::path temp = path;
+		temp += "." + std::to_string(random()) + "-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+		{
+			std::ofstream os(temp, std::ios::binary);
+			ProgramImage::Write(compiled, entry, os, file);
+			os.flush();
+			if (!os) {
+				std::error_code ec;
+				std::filesystem::remove(temp, ec);
+				throw std::invalid_argument("Cannot write program image " + temp.string() + "\n");
+			}
+		}
+		std::unique_ptr<ProgramImage> image;
+		try {
+			image = std::make_unique<ProgramImage>(temp.string());
+		}
+		catch (const std::invalid_argument&) {
+			std::error_code ec;
+			std::filesystem::remove(temp, ec);
+			throw;
+		}
+		std::error_code ec;
+		std::filesystem::rename(temp, path, ec);
+		if (ec) std::filesystem::remove(temp, ec); // another process holds an image in place; ours is still mapped
+		return image;
+	}
+};
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <fstream>
+
+#include "MappedProgram.h"
+
+// A ProgramImage is a loaded machine saved to disk, so starting it again is one mmap and no parsing or decoding.
+// It is not zero-copy: Install copies the programs and the tape out of the mapping, as the state table owns its programs and the tape its cells.
+// It holds the state table with the names and the accepting set, every program already decoded to the concepts that run it, the initial tape, and the entry lines to run at start.
+// It also keeps the program text it was compiled from, so a cache can tell its image from that of another program under the same name.
+//
+// Layout, little endian, every field a u64 and every byte string padded to 8 bytes:
+//   "AMIM" u32 version | fingerprint | tape order | head | current state | tape cells | states | entries | source length
+//   entry state ids | source, every line as a u64 length and its bytes | tape cells, one byte each
+//   per state: id | flags (1 named, 2 accepting, 4 decoded) | name length | program length | instructions | name | program | instructions, 6 x u32 each (24 bytes)
+// The fingerprint covers the concepts of the machine language and of every resource, since decoded instructions refer to them by position.
+class ProgramImage : public MappedFile {
+public:
+	static constexpr std::uint32_t Version = 2;
+
+	enum Flags : std::uint64_t { Named = 1, Accepting = 2, Precompiled = 4 };
+
+	explicit ProgramImage(const std::string& path) : MappedFile(path) {
+		Reader in{ data, data + length };
+		if (length < 8 || std::u8string_view(data, 4) != u8"AMIM") throw std::invalid_argument("Not a program image: " + path + "\n");
+		in.p += 4;
+		if (in.U32() != Version) throw std::invalid_argument("Unsupported program image version: " + path + "\n");
+		fingerprint = in.U64();
+		order = in.U64();
+		head = static_cast<long long>(in.U64());
+		state = in.U64();
+		cells = in.U64();
+		states = in.U64();
+		entries = in.U64();
+		sourcelength = in.U64();
+		body = in.p;
+		// Every count is of things at least a byte long each, so none can exceed the file. Bounding them here keeps the sizes computed from them from overflowing.
+		if (entries > length / 8 || sourcelength > length || cells > length || states > length) throw std::invalid_argument("Program image is truncated: " + path + "\n");
+	}
+
+	unsigned long Order() const { return static_cast<unsigned long>(order); }
+
+	// Loads every line of file into a fresh machine with a tape of the given order, decodes every state and writes the image to path.
+	// The lines that do not name a state are the entry lines, run in order when the image starts.
+	static void Compile(const ProgramFile<char8_t>& file, const std::string& path, unsigned long order = 16) {
+		AbstractMachine machine(order);
+		std::vector<unsigned long long> entry = Load(machine, file);
+		std::ofstream os(path, std::ios::binary);
+		Write(machine, entry, os, file);
+		if (!os) throw std::invalid_argument("Cannot write program image " + path + "\n");
+	}
+
+	// Loads every line of file into machine and returns the states of the entry lines, in order.
+	static std::vector<unsigned long long> Load(AbstractMachine& machine, const ProgramFile<char8_t>& file) {
+		std::vector<unsigned long long> entry;
+		for (const Medium<char8_t>& line : file) {
+			unsigned long long st = machine.LoadState(line);
+			if (machine.StateRegister->states.contains(st) && !machine.StateRegister->named.contains(st)) entry.push_back(st);
+		}
+		return entry;
+	}
+
+	// Writes machine as it stands, decoding the states it can. entry lists the states to run, in order, when the image starts,
+	// and source is the program the machine was loaded from.
+	static void Write(AbstractMachine& machine, const std::vector<unsigned long long>& entry, std::ostream& os, const ProgramFile<char8_t>& source = {}) {
+		auto u64 = [&os](unsigned long long value) {
+			for (int i = 0; i < 8; ++i) os.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+		};
+		auto u32 = [&os](std::uint32_t value) {
+			for (int i = 0; i < 4; ++i) os.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+		};
+		auto bytes = [&os](const char8_t* p, std::size_t n) {
+			os.write(reinterpret_cast<const char*>(p), static_cast<std::streamsize>(n));
+			for (std::size_t i = n; i % 8 != 0; ++i) os.put(0);
+		};
+
+		States& reg = *machine.StateRegister;
+		const std::valarray<bool>& tape = machine.Tape->Tape;
+		const std::u8string text = Source(source);
+
+		os.write("AMIM", 4);
+		u32(Version);
+		u64(Fingerprint(machine));
+		u64(machine.Tape->order);
+		u64(static_cast<unsigned long long>(machine.Tape->head));
+		u64(reg.state);
+		u64(tape.size());
+		u64(reg.states.size());
+		u64(entry.size());
+		u64(text.size());
+		for (unsigned long long st : entry) u64(st);
+		bytes(text.data(), text.size());
+
+		std::u8string cells(tape.size(), u8'\0');
+		for (std::size_t i = 0; i < tape.size(); ++i) cells[i] = tape[i] ? 1 : 0;
+		bytes(cells.data(), cells.size());
+
+		for (const auto& [st, token] : reg.states) {
+			const Medium<char8_t>& prog = std::get<Medium<char8_t>>(token);
+			std::uint64_t flags = 0;
+			Medium<char8_t> name;
+			if (reg.named.contains(st)) {
+				flags |= Named;
+				name = reg.named.at(st);
+			}
+			if (reg.accepting.contains(st)) flags |= Accepting;
+			const std::vector<Instruction>* code = machine.Precompile(st) ? reg.Decoded(st) : nullptr;
+			if (code != nullptr) flags |= Precompiled;
+
+			u64(st);
+			u64(flags);
+			u64(name.size());
+			u64(prog.size());
+			u64(code ? code->size() : 0);
+			bytes(name.data(), name.size());
+			bytes(prog.data(), prog.size());
+			if (code != nullptr) {
+				for (const Instruction& i : *code) {
+					u32(i.begin);
+					u32(i.length);
+					u32(i.operand);
+					u32(i.size);
+					u32(static_cast<std::uint32_t>(i.resource));
+					u32(i.rule);
+				}
+			}
+		}
+	}
+
+	// Identifies the languages a machine recognizes programs with: the names of their concepts, in order, and which are literals.
+	static std::uint64_t Fingerprint(const AbstractMachine& machine) {
+		std::uint64_t hash = 14695981039346656037ULL; // FNV-1a
+		auto mix = [&hash](const Medium<char8_t>& bytes) {
+			for (char8_t c : bytes) {
+				hash ^= c;
+				hash *= 1099511628211ULL;
+			}
+			hash ^= 0xFF;
+			hash *= 1099511628211ULL;
+		};
+		auto language = [&mix](const Language<char8_t>& lang) {
+			for (const auto& c : lang.I) {
+				mix(Statistics::Name(std::get<0>(c)));
+				mix(lang.is_literal(c) ? u8"literal" : u8"");
+			}
+			mix(u8"end of language");
+		};
+		hash ^= Version;
+		hash *= 1099511628211ULL;
+		language(machine.language);
+		for (const auto& res : machine.Resources) language(res->language);
+		return hash;
+	}
+
+	// Whether the image was compiled for the languages of machine, so Install takes it.
+	bool Fits(const AbstractMachine& machine) const { return fingerprint == Fingerprint(machine); }
+
+	// Whether the image was compiled from exactly the lines of file.
+	bool Holds(const ProgramFile<char8_t>& file) const {
+		Reader in{ body, data + length };
+		try {
+			in.Bytes(entries * 8);
+			return in.Bytes(sourcelength) == Source(file);
+		}
+		catch (const std::invalid_argument&) { return false; } // truncated
+	}
+
+	// The bytes an image keeps of file: every line as a u64 length and its bytes.
+	static std::u8string Source(const ProgramFile<char8_t>& file) {
+		std::u8string text;
+		for (const Medium<char8_t>& line : file) {
+			for (int i = 0; i < 8; ++i) text.push_back(static_cast<char8_t>((line.size() >> (8 * i)) & 0xFF));
+			text.append(line.begin(), line.end());
+		}
+		return text;
+	}
+
+	// Replaces the states and tape of machine by those of the image.
+	// The whole image is read and checked before machine is touched, so an image that is truncated or does not hold together leaves machine as it was.
+	// That costs one copy of every program, instruction and tape cell, linear in the size of the image, and the mapping can be dropped afterwards.
+	void Install(AbstractMachine& machine) const {
+		Statistics::Timer timer(machine.stats, Statistics::Phase::Load);
+		if (!Fits(machine)) throw std::invalid_argument("Program image was compiled for a different language\n");
+		if (order == 0 || order >= 64 || cells != std::uint64_t(1) << order) throw std::invalid_argument("Program image has a tape of a bad order\n");
+		const long long half = 1LL << (order - 1);
+		if (head < -half || head >= half) throw std::invalid_argument("Program image has its head off the tape\n");
+
+		Reader in{ body, data + length };
+		in.Bytes(entries * 8);
+		in.Bytes(sourcelength);
+
+		std::u8string_view cellbytes = in.Bytes(cells);
+		std::valarray<bool> tape(cells);
+		for (std::size_t i = 0; i < cells; ++i) tape[i] = cellbytes[i] != 0;
+
+		std::unordered_map<unsigned long long, Token<char8_t>> programs;
+		std::map<unsigned long long, Medium<char8_t>> named;
+		std::set<unsigned long long> accepting;
+		std::unordered_map<unsigned long long, std::vector<Instruction>> decoded;
+		for (unsigned long long n = 0; n < states; ++n) {
+			unsigned long long st = in.U64();
+			std::uint64_t flags = in.U64();
+			unsigned long long namelength = in.U64(), proglength = in.U64(), count = in.U64();
+			if (flags & ~std::uint64_t(Named | Accepting | Precompiled)) throw std::invalid_argument("Program image has a state with unknown flags\n");
+			if (!(flags & Precompiled) && count != 0) throw std::invalid_argument("Program image has instructions for a state that is not decoded\n");
+			if (count > static_cast<std::size_t>(in.end - in.p) / 24) throw std::invalid_argument("Program image is truncated\n");
+			std::u8string_view name = in.Bytes(namelength);
+			if (!programs.emplace(st, Medium<char8_t>(in.Bytes(proglength))).second) throw std::invalid_argument("Program image defines a state twice\n");
+			if (flags & Named) named[st] = Medium<char8_t>(name);
+			if (flags & Accepting) accepting.insert(st);
+			if (flags & Precompiled) {
+				std::vector<Instruction>& code = decoded[st];
+				code.reserve(count);
+				for (unsigned long long i = 0; i < count; ++i) {
+					Instruction instruction{};
+					instruction.begin = in.U32();
+					instruction.length = in.U32();
+					instruction.operand = in.U32();
+					instruction.size = in.U32();
+					instruction.resource = static_cast<std::int32_t>(in.U32());
+					instruction.rule = in.U32();
+					if (!Valid(machine, instruction, proglength)) throw std::invalid_argument("Program image has an instruction outside its program or language\n");
+					code.push_back(instruction);
+				}
+			}
+		}
+
+		States& reg = *machine.StateRegister;
+		reg.states = std::move(programs);
+		reg.decoded = std::move(decoded);
+		reg.named = std::move(named);
+		reg.accepting = std::move(accepting);
+		++reg.edits; // what was learnt from the old programs, and any frame running one, must let go of them
+		reg.previous.clear();
+		reg.instnum.clear();
+		machine.macros.Clear();
+		reg.state = state;
+		reg.icount = 0;
+
+		machine.Tape->order = static_cast<unsigned char>(order);
+		machine.Tape->head = head;
+		machine.Tape->Tape = std::move(tape);
+		if (machine.Tape->hashing) machine.Tape->Rehash();
+		machine.stats.allocations += 1;
+		machine.stats.allocated += Substrate<bool>::Bytes(cells);
+		machine.stats.order = std::max<unsigned long long>(machine.stats.order, order);
+		for (std::size_t n = 0; n <= reg.decoded.size(); ++n) machine.stats.Allocation(); // the tape and every decoded program
+	}
+
+	// Runs the entry lines of the image on machine, in order, as LoadAndRun runs the lines of a file.
+	unsigned long long Run(AbstractMachine& machine, ResultSink& sink) const {
+		Reader in{ body, data + length };
+		unsigned long long consumed = 0;
+		for (unsigned long long n = 0; n < entries; ++n) {
+			unsigned long long st = in.U64();
+			if (machine.StateRegister->states.contains(st)) consumed += machine.RunState(st, sink);
+		}
+		return consumed;
+	}
+
+private:
+	std::uint64_t fingerprint = 0;
+	unsigned long long order = 0;
+	long long head = 0;
+	unsigned long long state = 0;
+	unsigned long long cells = 0;
+	unsigned long long states = 0;
+	unsigned long long entries = 0;
+	unsigned long long sourcelength = 0;
+	const char8_t* body = nullptr; // the entry ids, after the header
+
+	// Whether instruction lies within a program of proglength characters and names a concept machine has.
+	static bool Valid(const AbstractMachine& machine, const Instruction& instruction, unsigned long long proglength) {
+		if (std::uint64_t(instruction.begin) + instruction.length > proglength) return false;
+		if (std::uint64_t(instruction.operand) + instruction.size > proglength) return false;
+		if (instruction.resource < -1 || instruction.resource >= static_cast<std::int64_t>(machine.Resources.size())) return false;
+		const Language<char8_t>& lang = instruction.resource < 0 ? machine.language : machine.Resources[static_cast<std::size_t>(instruction.resource)]->language;
+		return instruction.rule < lang.I.size();
+	}
+
+	// Reads little endian fields off the mapping, refusing to run past its end.
+	struct Reader {
+		const char8_t* p;
+		const char8_t* end;
+
+		void Need(std::size_t n) {
+			if (static_cast<std::size_t>(end - p) < n) throw std::invalid_argument("Program image is truncated\n");
+		}
+
+		std::uint64_t U64() {
+			Need(8);
+			std::uint64_t value = 0;
+			for (int i = 0; i < 8; ++i) value |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+			p += 8;
+			return value;
+		}
+
+		std::uint32_t U32() {
+			Need(4);
+			std::uint32_t value = 0;
+			for (int i = 0; i < 4; ++i) value |= static_cast<std::uint32_t>(p[i]) << (8 * i);
+			p += 4;
+			return value;
+		}
+
+		// n bytes, skipping the padding after them
+		std::u8string_view Bytes(std::size_t n) {
+			Need(n); // first, so the padding cannot overflow
+			std::size_t padded = (n + 7) / 8 * 8;
+			Need(padded);
+			std::u8string_view bytes(p, n);
+			p += padded;
+			return bytes;
+		}
+	};
+};
+
+// Images hold bool tapes, so only an AbstractMachine starts from one.
+template <Value V>
+inline BasicMachine<V>::BasicMachine(const ProgramImage& image) requires std::same_as<V, bool> : BasicMachine(image.Order()) {
+	image.Install(*this);
+	image.Run(*this, Discard);
+}
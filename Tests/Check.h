@@ -0,0 +1,33 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include "../Language.h"
+
+// The tests are plain programs: each Check that fails prints what was expected, and main returns Failures() so ctest sees a non-zero exit.
+inline int& Failures() {
+	static int failures = 0;
+	return failures;
+}
+
+inline void Check(bool ok, const std::string& what) {
+	if (ok) return;
+	std::cerr << "FAILED: " << what << "\n";
+	++Failures();
+}
+
+// Where a machine ended: the cells around the origin, the head and the state.
+struct Outcome {
+	std::vector<bool> cells;
+	long long head;
+	unsigned long long state;
+
+	bool operator==(const Outcome&) const = default;
+};
+
+inline Outcome Snapshot(AbstractMachine& machine) {
+	Outcome outcome{ {}, machine.Tape->Head(), machine.StateRegister->state };
+	for (long long cell = -64; cell <= 64; ++cell) outcome.cells.push_back(machine.Tape->At(cell));
+	return outcome;
+}
@@ -0,0 +1,115 @@
+// Executor.cpp : An execution resumed a slice at a time must end as Run does, keep nested runs and calls within its budget and in order,
+// a machine must run one execution at a time, and a scheduler must finish what was submitted to it before it goes.
+
+#include "Check.h"
+#include "../Executor.h"
+
+const ProgramFile<char8_t> Nested = {
+	u8"name W write 1; right",
+	u8"name Y call W; left; write 0; right; call W; left",
+	u8"name Z nothing",
+	u8"call W; run right; call W; run call W; left; left; write 0",
+	u8"run jump Y; left; run jump Z; write 1",
+};
+
+const ProgramFile<char8_t> Sweep = {
+	u8"name A write 1; right; jump B",
+	u8"name B right; jump C",
+	u8"name C branch D A",
+	u8"name D nothing",
+	u8"jump A",
+};
+
+Outcome Plain(const ProgramFile<char8_t>& file, bool accelerate = false) {
+	AbstractMachine machine;
+	machine.Accelerate(accelerate);
+	machine.LoadAndRun(file, machine.Discard);
+	return Snapshot(machine);
+}
+
+Outcome Sliced(const ProgramFile<char8_t>& file, unsigned long long budget, bool accelerate = false, bool decoded = false) {
+	AbstractMachine machine;
+	machine.Accelerate(accelerate);
+	if (decoded) {
+		for (const Medium<char8_t>& line : file) machine.Precompile(machine.LoadState(line));
+	}
+	Execution execution(machine, file);
+	execution.Complete(budget);
+	Check(machine.StateRegister->previous.empty(), "every call returned");
+	return Snapshot(machine);
+}
+
+int main() {
+	for (unsigned long long budget : { 1ULL, 2ULL, 3ULL, 1024ULL }) {
+		std::string slice = " in slices of " + std::to_string(budget);
+		Check(Sliced(Nested, budget) == Plain(Nested), "nested runs and calls" + slice + " run in order");
+		Check(Sliced(Nested, budget, false, true) == Plain(Nested), "decoded nested runs and calls" + slice + " run in order");
+		Check(Sliced(Sweep, budget) == Plain(Sweep), "jumps" + slice + " end as Run does");
+		Check(Sliced(Sweep, budget, true) == Plain(Sweep, true), "macro steps" + slice + " end as Run does");
+		Check(Sliced(Sweep, budget, true, true) == Plain(Sweep), "decoded macro steps" + slice + " end as Run does");
+	}
+
+	{
+		// A loop in a run command or a called state is still cut into slices.
+		AbstractMachine machine;
+		machine.LoadAndRun(ProgramFile<char8_t>{ u8"name L right; jump L" }, machine.Discard);
+		for (const char8_t* program : { u8"run jump L", u8"call L", u8"run run call L" }) {
+			Execution execution(machine, Medium<char8_t>(program));
+			Check(execution.Resume(100) == Execution::Status::Suspended && execution.steps == 100, "an endless nested program stops at the budget");
+			execution.Cancel();
+			Check(execution.Resume(100) == Execution::Status::Cancelled, "a cancelled execution ends");
+			Check(machine.StateRegister->previous.empty() && machine.Frames == nullptr, "a cancelled execution unwinds its calls");
+		}
+
+		// A time budget stops an endless program too, the clock being read every Tick steps.
+		Execution timed(machine, Medium<char8_t>(u8"run jump L"));
+		Check(timed.Resume(1ULL << 40, std::chrono::microseconds(500)) == Execution::Status::Suspended, "an endless program stops at the time budget");
+		Check(timed.steps > 0 && timed.steps % Execution::Tick == 0, "the time budget is checked every Tick steps");
+		timed.Cancel();
+		timed.Resume(1);
+	}
+
+	{
+		// Executions still queued when the scheduler goes are finished, not dropped.
+		std::vector<std::unique_ptr<AbstractMachine>> machines;
+		std::vector<std::shared_ptr<Execution>> executions;
+		{
+			Scheduler scheduler(2, 3);
+			for (int i = 0; i < 8; ++i) {
+				machines.push_back(std::make_unique<AbstractMachine>());
+				executions.push_back(std::make_shared<Execution>(*machines.back(), Sweep));
+				scheduler.Submit(executions.back());
+			}
+		}
+		for (std::size_t i = 0; i < executions.size(); ++i) {
+			Check(executions[i]->status == Execution::Status::Done, "a queued execution is finished by the scheduler going");
+			Check(Snapshot(*machines[i]) == Plain(Sweep), "a scheduled execution ends as Run does");
+		}
+	}
+
+	{
+		// An execution resumed while another runs on its machine is refused, and left to be resumed later.
+		struct Reentrant : ResultSink {
+			Execution* other = nullptr;
+			bool refused = false;
+			void Push(const Token<char8_t>&, std::any&&, unsigned long long) override {
+				try {
+					other->Resume(1);
+				}
+				catch (const std::logic_error&) {
+					refused = true;
+				}
+			}
+		};
+		AbstractMachine machine;
+		Reentrant sink;
+		Execution second(machine, Medium<char8_t>(u8"right"));
+		sink.other = &second;
+		Execution first(machine, Medium<char8_t>(u8"write 1"), sink);
+		first.Complete();
+		Check(sink.refused && second.status == Execution::Status::Ready, "a second execution of a running machine is refused");
+		Check(second.Complete() == Execution::Status::Done && Snapshot(machine).head == 1, "the refused execution runs once the machine is free");
+	}
+
+	return Failures();
+}
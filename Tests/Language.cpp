@@ -0,0 +1,90 @@
+// Language.cpp : What the machine language accepts: instructions separated by ';', states defined by name and entered by jump and branch,
+// later concepts taking precedence over the character classes, and an instruction no concept takes, or whose syntax rejects it, being an error rather than a literal.
+
+#include "Check.h"
+
+Outcome Loaded(const ProgramFile<char8_t>& file) {
+	AbstractMachine machine;
+	machine.LoadAndRun(file, machine.Discard);
+	return Snapshot(machine);
+}
+
+bool Throws(const char8_t* program, const std::string& message = "") {
+	AbstractMachine machine;
+	try {
+		machine.Run(Medium<char8_t>(program), machine.Discard);
+	}
+	catch (const std::invalid_argument& e) {
+		return std::string(e.what()).starts_with(message);
+	}
+	return false;
+}
+
+int main() {
+	{
+		// Instructions on a line run in order, whatever space is around the ';'.
+		Outcome outcome = Loaded({ u8"write 1; right;right ;  write 1;; right" });
+		Check(outcome.cells[64] && !outcome.cells[65] && outcome.cells[66] && outcome.head == 3, "instructions separated by ';' run in order");
+	}
+
+	{
+		// A name line defines a state without running it, and jump and branch carry on with the program of the state they name.
+		Outcome defined = Loaded({ u8"name A write 1; right; jump B" });
+		Check(!defined.cells[64] && defined.head == 0, "a name line does not run its program");
+
+		Outcome swept = Loaded({
+			u8"name A write 1; right; jump B",
+			u8"name B right; jump C",
+			u8"name C branch D A",
+			u8"name D nothing",
+			u8"jump A; write 1",
+		});
+		Check(swept.cells[64] && !swept.cells[65] && !swept.cells[66] && swept.head == 2, "jump abandons the rest of the line and branch reads the cell");
+
+		AbstractMachine machine;
+		machine.LoadAndRun(ProgramFile<char8_t>{ u8"name D nothing", u8"name E nothing", u8"write 1; branch D E" }, machine.Discard);
+		Check(machine.StateRegister->state == machine.LoadState(u8"name E nothing"), "branch on a 1 takes the second state");
+	}
+
+	{
+		// The concepts registered last are tried first, and among the character classes the most specialized takes a token.
+		Language<char8_t> language;
+		language.AddCharacterInterpretations();
+		auto digits = language.Recognize(Medium<char8_t>(u8"0110"));
+		Check(digits && std::get<0>(*digits->first) == Token<char8_t>(Medium<char8_t>(u8"digit")), "a digit string is a digit, not printable");
+		language.Interpret(CharClass{}, Medium<char8_t>(u8"binary"), [](const Token<char8_t>& prog) {
+			const Medium<char8_t>& text = std::get<Medium<char8_t>>(prog);
+			return text.find_first_not_of(u8"01") == Medium<char8_t>::npos ? static_cast<unsigned long long>(text.size()) : 0ULL;
+		}, [](const Token<char8_t>&) { return std::any(true); });
+		auto binary = language.Recognize(Medium<char8_t>(u8"0110"));
+		Check(binary && std::get<0>(*binary->first) == Token<char8_t>(Medium<char8_t>(u8"binary")), "a later concept takes precedence over a character class");
+	}
+
+	{
+		// Adding symbols already in the alphabet still adds the rest.
+		Language<char8_t> language;
+		language.AddSymbols(Token<char8_t>(Medium<char8_t>(u8"a")));
+		Check(!language.AddSymbols(Token<char8_t>(Medium<char8_t>(u8"aab"))), "adding a symbol twice reports it");
+		Check(language.A.contains(u8'b'), "the symbols after a duplicate are added");
+	}
+
+	// A literal is a single word that is neither a command word nor an unknown one.
+	Check(!Throws(u8"0110"), "a digit string is a literal");
+	Check(!Throws(u8"write 1; +"), "punctuation is a literal");
+	Check(Throws(u8"frobnicate"), "an unknown word is not a literal");
+	Check(Throws(u8"frob1"), "an unknown word with digits is not a literal");
+	Check(Throws(u8"write 1; frobnicate; write 0"), "an unknown word between instructions is not a literal");
+	Check(Throws(u8"01 10"), "two words are not a literal");
+
+	// A command its syntax rejects ends the search there, and throws rather than being tried as a literal.
+	Check(Throws(u8"write", "Malformed instruction"), "a write without a value is malformed");
+	Check(Throws(u8"write 12abc", "Malformed instruction"), "a write of a value with trailing characters is malformed");
+	Check(Throws(u8"write 1; write 2", "Malformed instruction"), "a write of a value that is not a symbol is malformed");
+	Check(Throws(u8"tape write", "Malformed instruction"), "a malformed write after a resource name is malformed");
+	{
+		AbstractMachine machine;
+		Check(!machine.Precompile(machine.LoadState(u8"name M write 1; write")), "a state with a malformed instruction is not decoded ahead");
+	}
+
+	return Failures();
+}
@@ -0,0 +1,56 @@
+// MacroSteps.cpp : A machine with macro steps on must end with the same tape, head and state as one evaluating every instruction.
+
+#include "Check.h"
+
+Outcome Run(ProgramFile<char8_t> file, bool accelerate) {
+	if (accelerate) file.insert(file.begin(), u8"accelerate");
+	AbstractMachine machine;
+	machine.LoadAndRun(file, machine.Discard);
+	return Snapshot(machine);
+}
+
+void Same(const std::string& name, const ProgramFile<char8_t>& file) {
+	Check(Run(file, false) == Run(file, true), name + ": the accelerated machine ends somewhere else");
+}
+
+int main() {
+	// A loop of states sweeping right, replayed once the steps are known.
+	Same("sweep", {
+		u8"name A write 1; right; jump B",
+		u8"name B right; jump C",
+		u8"name C branch D A",
+		u8"name D nothing",
+		u8"jump A",
+	});
+
+	// A state redefined by load after its step was recorded must not replay the old body.
+	Same("load redefines a state", {
+		u8"name A write 1; jump Z",
+		u8"name Z nothing",
+		u8"jump A",
+		u8"load name A write 0",
+		u8"left; jump A",
+	});
+
+	// Nor may a step whose state calls a state that was redefined.
+	Same("load redefines a called state", {
+		u8"name W write 1",
+		u8"name A call W; right; jump Z",
+		u8"name Z nothing",
+		u8"jump A",
+		u8"load name W write 0",
+		u8"left; jump A",
+	});
+
+	// A state removed and loaded again with another body.
+	Same("unload and load", {
+		u8"name A write 1; jump Z",
+		u8"name Z nothing",
+		u8"jump A",
+		u8"unload A",
+		u8"load name A right; write 1; jump Z",
+		u8"left; jump A",
+	});
+
+	return Failures();
+}
@@ -0,0 +1,76 @@
+// ProgramCache.cpp : Programs run through a cache must end as they do when loaded from text, whether the cache hits, misses,
+// finds another program's image under the name, or evicts the image it just compiled.
+
+#include <fstream>
+
+#include "Check.h"
+#include "../ProgramCache.h"
+
+const ProgramFile<char8_t> Sweep = {
+	u8"name A write 1; right; jump B",
+	u8"name B right; jump C",
+	u8"name C branch D A",
+	u8"name D nothing",
+	u8"jump A",
+};
+
+const ProgramFile<char8_t> Other = {
+	u8"name A write 1; left; write 1; left; jump Z",
+	u8"name Z nothing",
+	u8"jump A",
+};
+
+Outcome Plain(const ProgramFile<char8_t>& file) {
+	AbstractMachine machine;
+	machine.LoadAndRun(file, machine.Discard);
+	return Snapshot(machine);
+}
+
+Outcome Cached(ProgramCache& cache, const ProgramFile<char8_t>& file) {
+	AbstractMachine machine;
+	cache.LoadAndRun(machine, file, machine.Discard);
+	return Snapshot(machine);
+}
+
+std::size_t Images(const std::filesystem::path& dir) {
+	std::size_t n = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(dir)) n += entry.path().extension() == ".amim";
+	return n;
+}
+
+int main() {
+	const std::filesystem::path dir = std::filesystem::temp_directory_path() / ("ProgramCacheTest-" + std::to_string(std::random_device{}()));
+	std::filesystem::remove_all(dir);
+	{
+		ProgramCache cache(dir);
+		Check(Cached(cache, Sweep) == Plain(Sweep), "a miss runs as the text does");
+		Check(cache.misses == 1 && cache.hits == 0, "the first run misses");
+		Check(Images(dir) == 1, "a miss leaves one image behind");
+
+		ProgramCache again(dir); // as another process would
+		Check(Cached(again, Sweep) == Plain(Sweep), "a hit runs as the text does");
+		Check(again.hits == 1 && again.misses == 0, "the second run hits");
+
+		// The image of Sweep under the name of Other, as a hash collision would leave it.
+		AbstractMachine machine;
+		std::filesystem::copy_file(cache.Path(ProgramCache::Key(machine, Sweep)), cache.Path(ProgramCache::Key(machine, Other)));
+		Check(Cached(again, Other) == Plain(Other), "another program's image is not taken");
+		Check(again.misses == 1, "another program's image is a miss");
+		Check(Cached(again, Other) == Plain(Other) && again.hits == 2, "the recompiled image hits");
+
+		// A file under the name that is not an image at all.
+		std::filesystem::remove(cache.Path(ProgramCache::Key(machine, Sweep)));
+		std::ofstream(cache.Path(ProgramCache::Key(machine, Sweep)), std::ios::binary) << "not a program image";
+		Check(Cached(again, Sweep) == Plain(Sweep), "a broken image is compiled again");
+	}
+	{
+		// Every image outgrows this cache, including the one a miss just compiled, which still runs.
+		ProgramCache tiny(dir, 1);
+		tiny.Evict();
+		Check(Images(dir) == 0, "eviction removes the images past the capacity");
+		Check(Cached(tiny, Sweep) == Plain(Sweep), "an image evicted as it is compiled still runs");
+		Check(Images(dir) == 0, "the image compiled past the capacity is evicted");
+	}
+	std::filesystem::remove_all(dir);
+	return Failures();
+}
@@ -0,0 +1,114 @@
+// ProgramImage.cpp : A machine started from an image must end as one that loaded the program text, and an image that is
+// truncated or does not hold together must be refused without touching the machine it was installed on.
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "Check.h"
+#include "../ProgramImage.h"
+
+const ProgramFile<char8_t> Sweep = {
+	u8"name A write 1; right; jump B",
+	u8"name B right; jump C",
+	u8"name C branch D A",
+	u8"name D nothing",
+	u8"jump A",
+};
+
+const ProgramFile<char8_t> Other = {
+	u8"name A write 1; left; write 1; left; jump Z",
+	u8"name Z nothing",
+	u8"jump A",
+};
+
+const std::filesystem::path Dir = std::filesystem::temp_directory_path() / ("ProgramImageTest-" + std::to_string(std::random_device{}()));
+
+std::string Image(const ProgramFile<char8_t>& file) {
+	AbstractMachine machine;
+	std::vector<unsigned long long> entry = ProgramImage::Load(machine, file);
+	std::ostringstream os;
+	ProgramImage::Write(machine, entry, os, file);
+	return os.str();
+}
+
+std::string Save(const std::string& bytes, const std::string& name) {
+	std::filesystem::path path = Dir / name;
+	std::ofstream(path, std::ios::binary) << bytes;
+	return path.string();
+}
+
+Outcome Plain(const ProgramFile<char8_t>& file) {
+	AbstractMachine machine;
+	machine.LoadAndRun(file, machine.Discard);
+	return Snapshot(machine);
+}
+
+// Installs the image in bytes on a machine that ran Other, and checks it is refused with the machine left as it was.
+void Refused(const std::string& bytes, const std::string& what) {
+	AbstractMachine machine;
+	machine.LoadAndRun(Other, machine.Discard);
+	const Outcome before = Snapshot(machine);
+	const auto states = machine.StateRegister->states;
+	const auto named = machine.StateRegister->named;
+	bool refused = false;
+	try {
+		ProgramImage image(Save(bytes, "refused.amim"));
+		image.Install(machine);
+	}
+	catch (const std::invalid_argument&) { refused = true; }
+	Check(refused, what + " is refused");
+	Check(Snapshot(machine) == before && machine.StateRegister->states == states && machine.StateRegister->named == named, what + " leaves the machine as it was");
+}
+
+void Put32(std::string& bytes, std::size_t at, std::uint32_t value) {
+	for (int i = 0; i < 4; ++i) bytes[at + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+int main() {
+	std::filesystem::create_directories(Dir);
+	const std::string sweep = Image(Sweep);
+	{
+		// Round trip: the image starts where the loaded text does, with the same states, and runs on from there the same way.
+		ProgramImage image(Save(sweep, "sweep.amim"));
+		Check(image.Holds(Sweep) && !image.Holds(Other), "the image holds the text it was compiled from");
+		AbstractMachine started(image);
+		AbstractMachine loaded;
+		loaded.LoadAndRun(Sweep, loaded.Discard);
+		Check(Snapshot(started) == Snapshot(loaded), "the image ends as the text does");
+		Check(started.StateRegister->states == loaded.StateRegister->states && started.StateRegister->named == loaded.StateRegister->named, "the image has the states of the text");
+		Check(started.StateRegister->decoded.size() == started.StateRegister->states.size(), "every state of the image is decoded");
+		started.LoadAndRun(ProgramFile<char8_t>{ u8"left; jump A" }, started.Discard);
+		loaded.LoadAndRun(ProgramFile<char8_t>{ u8"left; jump A" }, loaded.Discard);
+		Check(Snapshot(started) == Snapshot(loaded), "the started machine runs on as the loaded one does");
+	}
+
+	for (std::size_t n = 0; n < sweep.size(); ++n) {
+		if (n % 8 != 0 && n > 64) continue; // every byte of the header, then every field
+		Refused(sweep.substr(0, n), "an image truncated to " + std::to_string(n) + " bytes");
+	}
+
+	std::string bad = sweep;
+	Put32(bad, 16, 70); // tape order
+	Refused(bad, "an image of order 70");
+	bad = sweep;
+	Put32(bad, 28, 0x40000000); // the high half of the head
+	Refused(bad, "an image with its head off the tape");
+
+	// The instructions of state A follow its program, the last copy of its text in the image.
+	const std::string program = "write 1; right; jump B";
+	const std::size_t code = sweep.rfind(program) + (program.size() + 7) / 8 * 8;
+	bad = sweep;
+	Put32(bad, code, 0xFFFF); // begin
+	Refused(bad, "an instruction outside its program");
+	bad = sweep;
+	Put32(bad, code + 16, 1000); // resource
+	Refused(bad, "an instruction of a missing resource");
+	bad = sweep;
+	Put32(bad, code + 20, 0xFFFF); // rule
+	Refused(bad, "an instruction of a missing concept");
+
+	std::filesystem::remove_all(Dir);
+	return Failures();
+}
@@ -0,0 +1,46 @@
+// Statistics.cpp : The machine must count the instructions of every concept, and charge time and allocations to the phase they were spent in.
+
+#include "Check.h"
+
+int main() {
+	AbstractMachine machine;
+	machine.LoadAndRun(ProgramFile<char8_t>{
+		u8"name A write 1; right; write 1; right; jump B",
+		u8"name B left; nothing",
+		u8"jump A",
+	}, machine.Discard);
+	const Statistics& stats = machine.stats;
+
+	Check(stats.Counter(u8"write") == 2u, "write is counted per instruction");
+	Check(stats.Counter(u8"right") == 2u && stats.Counter(u8"left") == 1u, "moves are counted per concept");
+	Check(stats.Counter(u8"jump") == 2u, "jump is counted per instruction");
+	unsigned long long total = 0;
+	for (const auto& [name, count] : stats.PerConcept()) total += count;
+	Check(total == stats.instructions, "the concepts add up to the instructions");
+	Check(stats.ToJSON().find("\"write\":2") != std::string::npos, "the JSON export names the concepts");
+
+	Check(stats.loadtime > 0 && stats.runtime > 0, "loading and running are timed");
+	Check(stats.decodetime == 0 && stats.decodeallocations == 0, "nothing is decoded ahead of time");
+	Check(stats.runallocations > 0, "the scratch tokens of the run are charged to it");
+	Check(stats.phase == Statistics::Phase::None, "no phase is left open");
+
+	unsigned long long runtime = stats.runtime, loadtime = stats.loadtime;
+	unsigned long long st = 0;
+	{
+		Statistics::Timer timer(machine.stats, Statistics::Phase::Run);
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		st = machine.LoadState(u8"write 0");
+	}
+	Check(machine.stats.runtime - runtime >= 2000000, "a phase is charged its wall time");
+	Check(machine.stats.loadtime > loadtime, "a load inside a run is charged to loading");
+
+	Check(machine.Precompile(st), "a state decodes ahead of time");
+	Check(stats.decodetime > 0 && stats.decodeallocations == 1, "decoding ahead of time is timed and its program counted");
+
+	machine.stats.Clear();
+	Check(machine.stats.instructions == 0 && machine.stats.PerConcept().empty(), "Clear zeroes the counters");
+	machine.LoadAndRun(ProgramFile<char8_t>{ u8"write 1" }, machine.Discard);
+	Check(machine.stats.Counter(u8"write") == 1u, "concepts are named after Clear");
+
+	return Failures();
+}
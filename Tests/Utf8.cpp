@@ -0,0 +1,114 @@
+// Utf8.cpp : The validator and decoder must agree with a plain reading of the standard on every short sequence,
+// wherever the sequence falls against the runs of ASCII the fast paths skip, and the machine must refuse a program that is not UTF-8.
+
+#include <random>
+
+#include "Check.h"
+
+// The length of the well-formed sequence at the front of text, or 0, decoding it and then checking the code point against the length.
+std::size_t Reference(std::u8string_view text, char32_t* decoded = nullptr) {
+	char8_t c = text[0];
+	std::size_t length = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+	if (length == 0 || text.size() < length) return 0;
+	char32_t code = length == 1 ? c : c & (0xFF >> (length + 1));
+	for (std::size_t k = 1; k < length; ++k) {
+		if ((text[k] & 0xC0) != 0x80) return 0;
+		code = (code << 6) | (text[k] & 0x3F);
+	}
+	static constexpr char32_t Least[] = { 0, 0, 0x80, 0x800, 0x10000 };
+	if (code < Least[length] || (code >= 0xD800 && code <= 0xDFFF) || code > 0x10FFFF) return 0;
+	if (decoded != nullptr) *decoded = code;
+	return length;
+}
+
+std::size_t ReferenceInvalid(std::u8string_view text) {
+	for (std::size_t i = 0; i < text.size();) {
+		std::size_t length = Reference(text.substr(i));
+		if (length == 0) return i;
+		i += length;
+	}
+	return Utf8::npos;
+}
+
+std::u8string Encode(char32_t c) {
+	if (c < 0x80) return { static_cast<char8_t>(c) };
+	if (c < 0x800) return { static_cast<char8_t>(0xC0 | (c >> 6)), static_cast<char8_t>(0x80 | (c & 0x3F)) };
+	if (c < 0x10000) return { static_cast<char8_t>(0xE0 | (c >> 12)), static_cast<char8_t>(0x80 | ((c >> 6) & 0x3F)), static_cast<char8_t>(0x80 | (c & 0x3F)) };
+	return { static_cast<char8_t>(0xF0 | (c >> 18)), static_cast<char8_t>(0x80 | ((c >> 12) & 0x3F)), static_cast<char8_t>(0x80 | ((c >> 6) & 0x3F)), static_cast<char8_t>(0x80 | (c & 0x3F)) };
+}
+
+int main() {
+	// Every sequence of up to three bytes, and every four byte one whose last two bytes are continuations or not.
+	int wrong = 0;
+	for (unsigned a = 0; a < 256; ++a) {
+		for (unsigned b = 0; b < 256; ++b) {
+			std::u8string two = { static_cast<char8_t>(a), static_cast<char8_t>(b) };
+			wrong += Utf8::Invalid(two) != ReferenceInvalid(two);
+			if (a < 0xE0) continue;
+			for (unsigned c = 0; c < 256; ++c) {
+				std::u8string three = two + static_cast<char8_t>(c);
+				wrong += Utf8::Invalid(three) != ReferenceInvalid(three);
+				if (a < 0xF0 || (c != 0x80 && c != 0xBF && c != 0x41 && c != 0xC0)) continue;
+				for (char8_t d : { 0x80, 0xBF, 0x41, 0xC0 }) {
+					std::u8string four = three + d;
+					wrong += Utf8::Invalid(four) != ReferenceInvalid(four);
+				}
+			}
+		}
+	}
+	Check(wrong == 0, std::to_string(wrong) + " short sequences judged unlike the standard");
+
+	// Every scalar value decodes back to itself, and surrogates do not validate.
+	wrong = 0;
+	for (char32_t c = 0; c <= 0x10FFFF; ++c) {
+		std::u8string text = Encode(c);
+		std::size_t pos = 0;
+		bool surrogate = c >= 0xD800 && c <= 0xDFFF;
+		if (surrogate) wrong += Utf8::Invalid(text) != 0;
+		else wrong += Utf8::Invalid(text) != Utf8::npos || Utf8::Decode(text, pos) != c || pos != text.size();
+	}
+	Check(wrong == 0, std::to_string(wrong) + " code points that do not round trip");
+
+	// A bad byte after ASCII runs of every length up to past the 32 byte fast path, and at random places in longer texts.
+	for (std::size_t run = 0; run < 80; ++run) {
+		for (char8_t bad : { 0x80, 0xC0, 0xF5, 0xFF }) {
+			std::u8string text(run, u8'a');
+			text += bad;
+			text += std::u8string(40, u8'b');
+			Check(Utf8::Invalid(text) == run, "a bad byte after " + std::to_string(run) + " ASCII bytes is found");
+			text[run] = u8'c';
+			Check(Utf8::Invalid(text) == Utf8::npos, "an ASCII run of " + std::to_string(run) + " bytes validates");
+		}
+	}
+	std::mt19937 random(46);
+	wrong = 0;
+	for (int n = 0; n < 20000; ++n) {
+		std::u8string text;
+		while (text.size() < 100) {
+			unsigned pick = random() % 8;
+			if (pick < 5) text.append(random() % 40, u8'x');
+			else if (pick < 7) text += Encode(static_cast<char32_t>(random() % 0x110000));
+			else text += static_cast<char8_t>(random());
+		}
+		wrong += Utf8::Invalid(text) != ReferenceInvalid(text);
+	}
+	Check(wrong == 0, std::to_string(wrong) + " random texts judged unlike the standard");
+
+	// The classes the tokenizers use.
+	Check(Utf8::IsSpace(U' ') && Utf8::IsSpace(0x3000) && Utf8::IsSpace(0x85) && !Utf8::IsSpace(0x200B), "White_Space");
+	Check(Utf8::IsName(u8"\u00E9tat") && Utf8::IsName(u8"\u540D\u524D") && !Utf8::IsName(u8"a1") && !Utf8::IsName(u8""), "names are letters in any script");
+	Check(Utf8::SpaceAt(u8"a\u3000b", 1) == 3 && Utf8::SpaceAt(u8"a\u00A0b", 1) == 2 && Utf8::SpaceAt(u8"ab", 1) == 0, "spaces are measured in bytes");
+
+	// The machine checks a program once, as it is loaded.
+	AbstractMachine machine;
+	bool refused = false;
+	try {
+		machine.LoadState(Medium<char8_t>(u8"write 1; \xC0\xAF"));
+	}
+	catch (const std::invalid_argument& e) {
+		refused = std::string(e.what()).find("byte 9") != std::string::npos;
+	}
+	Check(refused, "a program that is not UTF-8 is refused at the bad byte");
+
+	return Failures();
+}